@@ -0,0 +1,182 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <pars/ev/mpsc_queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Compare the enqueue latency of the dispatcher queue (pars::ev::mpsc_queue)
+// against the std::mutex + std::deque it replaced, with a growing number of
+// producers (nng callback threads, async jobs) and a single consumer.
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr auto pushes_per_producer = std::size_t{200'000};
+
+class locked_queue
+{
+public:
+  void push(std::size_t v)
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    queue_m.push_back(v);
+  }
+
+  std::optional<std::size_t> try_pop()
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    if (queue_m.empty())
+      return std::nullopt;
+
+    auto v = queue_m.front();
+
+    queue_m.pop_front();
+
+    return v;
+  }
+
+private:
+  std::mutex mtx_m;
+  std::deque<std::size_t> queue_m;
+};
+
+struct result
+{
+  double mean_ns;
+  double p99_ns;
+  double mops;
+};
+
+template<typename queue_t>
+result run(const std::size_t num_producers)
+{
+  auto q = queue_t{};
+  auto go = std::atomic<bool>{false};
+  auto latencies = std::vector<std::vector<double>>(num_producers);
+  auto total = num_producers * pushes_per_producer;
+
+  auto consumer = std::jthread{[&]() {
+    for (auto popped = std::size_t{0}; popped < total;)
+    {
+      if (q.try_pop())
+        ++popped;
+    }
+  }};
+
+  auto producers = std::vector<std::jthread>{};
+
+  for (auto p = std::size_t{0}; p < num_producers; ++p)
+  {
+    producers.emplace_back([&, p]() {
+      auto& lat = latencies[p];
+
+      lat.reserve(pushes_per_producer);
+
+      while (!go.load())
+        std::this_thread::yield();
+
+      for (auto i = std::size_t{0}; i < pushes_per_producer; ++i)
+      {
+        auto t0 = clock_type::now();
+
+        q.push(i);
+
+        lat.push_back(
+          std::chrono::duration<double, std::nano>(clock_type::now() - t0)
+            .count());
+      }
+    });
+  }
+
+  auto t0 = clock_type::now();
+
+  go.store(true);
+
+  producers.clear();
+  consumer.join();
+
+  auto elapsed = std::chrono::duration<double>(clock_type::now() - t0).count();
+
+  auto all = std::vector<double>{};
+
+  all.reserve(total);
+
+  for (auto& lat : latencies)
+    all.insert(all.end(), lat.begin(), lat.end());
+
+  auto p99 = all.begin() + static_cast<std::ptrdiff_t>(all.size() * 99 / 100);
+
+  std::nth_element(all.begin(), p99, all.end());
+
+  auto sum = double{0};
+
+  for (auto v : all)
+    sum += v;
+
+  return {.mean_ns = sum / static_cast<double>(all.size()),
+          .p99_ns = *p99,
+          .mops = static_cast<double>(total) / elapsed / 1e6};
+}
+
+void report(const char* name, const std::size_t num_producers, const result r)
+{
+  std::cout << name << "\tproducers: " << num_producers
+            << "\tmean: " << r.mean_ns << " ns\tp99: " << r.p99_ns
+            << " ns\tthroughput: " << r.mops << " Mops/s\n";
+}
+
+} // namespace
+
+int main()
+{
+  auto max_producers =
+    std::max(std::size_t{16}, std::size_t{std::thread::hardware_concurrency()});
+
+  for (auto n = std::size_t{1}; n <= max_producers; n *= 2)
+  {
+    report("mutex+deque", n, run<locked_queue>(n));
+    report("mpsc_queue ", n, run<pars::ev::mpsc_queue<std::size_t>>(n));
+  }
+
+  return 0;
+}
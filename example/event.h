@@ -74,6 +74,15 @@ struct stop_compute
   }
 };
 
+// a server backend arms a timer with this for every pipe accepted
+struct idle_pipe
+{
+  static constexpr std::string_view uuid =
+    "0b6f3e9a-72d4-4c1e-a8b5-d93e6f1c2a47";
+
+  net::pipe pipe;
+};
+
 } // namespace pars_example::event
 
 template<>
@@ -120,6 +120,8 @@ private:
 
     comp().rep().on<fired, network_error>(&self::close_pipe, this);
 
+    hfs().on<fired, timer_expired<idle_pipe>>(&self::close_idle_pipe, this);
+
     /// 4. commit state transition
     ts.commit();
 
@@ -157,6 +159,8 @@ private:
     {
       resources.emplace(md.pipe().id(), pipe_state::waiting_work);
 
+      timers().arm(cleanup_timeout, idle_pipe{md.pipe()});
+
       pars::info(SL, "{}: Fired {}, Pipe Accepted! [# resources: {} < {}]", md,
                  ev, resources_count, max_allowed);
     }
@@ -325,6 +329,34 @@ private:
     pars::info(SL, "{}: Fired {} (during {}), Pipe Closed!", md, ev, dir);
   }
 
+  /// close pipe, if still waiting work after cleanup_timeout
+  void close_idle_pipe(hf_arg<fired, timer_expired<idle_pipe>> fired)
+  {
+    state.ensure(server_state::running);
+
+    auto& ev = fired.event();
+
+    auto& p = ev.tag.pipe;
+
+    if (!resources.contains(p.id()))
+      return;
+
+    {
+      auto locked = resources.locked_resource(p.id());
+
+      if (locked.resource().state.current() != pipe_state::waiting_work)
+        return;
+    }
+
+    resources.delete_resource(p.id());
+
+    if (!p.close())
+      pars::warn(SL, "Fired {}, Pipe #{:X} already closed!", ev, p.id());
+    else
+      pars::info(SL, "Fired {}, Idle Pipe #{:X} Closed! [# resources: {}]", ev,
+                 p.id(), resources.count());
+  }
+
   /// graceful terminate
   void terminate(hf_arg<fired, shutdown> fired)
   {
@@ -0,0 +1,175 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/app/setup.h"
+#include "pars/ev/enqueuer.h"
+#include "pars/ev/shard.h"
+#include "pars/log.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace pars::app
+{
+
+/**
+ * @brief Runs a component on one shard per core (shared-nothing)
+ *
+ * Every shard owns a dispatcher, a runner and a snapshot of the handler
+ * functions inserted during startup. Contexts and pipes are spread across
+ * shards by the enqueuer, so that the shards never contend on a queue.
+ * Handler functions may run concurrently on different shards.
+ */
+template<typename component_t>
+class sharded : public with_default_setup
+{
+public:
+  using component_type = component_t;
+  using self_type = sharded<component_type>;
+
+  sharded(const std::size_t num_shards = default_num_shards())
+    : shards_m{make_shards(num_shards)}
+    , router_m{shards_m}
+    , component_m{shards_m.front()->hfs(), router_m}
+  {
+  }
+
+  int exec(int argc, char** argv)
+  {
+    atexit(nng_fini);
+
+    setup();
+
+    startup(argc, argv);
+
+    return run();
+  }
+
+protected:
+  component_type& comp() { return component_m; }
+
+  ev::enqueuer& router() { return router_m; }
+
+  /// the hf_registry of the first shard, cloned into the others on run
+  ev::hf_registry& hfs() { return shards_m.front()->hfs(); }
+
+  ev::shard& shard(const std::size_t shard_idx)
+  {
+    return *shards_m.at(shard_idx);
+  }
+
+  std::size_t num_shards() const { return shards_m.size(); }
+
+  virtual void startup(int argc, char** argv) = 0;
+
+  void graceful_terminate()
+  {
+    for (auto& s : shards_m)
+      s->dispatcher().stop_running();
+
+    component_m.graceful_terminate();
+
+    terminate_now();
+  }
+
+  void terminate_now()
+  {
+    for (auto& s : shards_m)
+      s->dispatcher().terminate_now();
+  }
+
+  void stop_job_thread(const int j_id)
+  {
+    for (auto& s : shards_m)
+      s->runner().stop_thread(j_id);
+  }
+
+  int run()
+  {
+    try
+    {
+      for (auto i = std::size_t{1}; i < shards_m.size(); ++i)
+        hfs().clone_into(shards_m[i]->hfs());
+
+      auto threads = std::vector<std::jthread>{};
+
+      for (auto i = std::size_t{1}; i < shards_m.size(); ++i)
+        threads.emplace_back(
+          [&s = *shards_m[i]]() { s.dispatcher().run(false); });
+
+      // events posted to a shard are discarded until it is running
+      for (auto i = std::size_t{1}; i < shards_m.size(); ++i)
+        while (shards_m[i]->dispatcher().terminating())
+          std::this_thread::yield();
+
+      pars::info(SL, lf::app, "Running {} shards", shards_m.size());
+
+      shards_m.front()->dispatcher().run();
+
+      return EXIT_SUCCESS;
+    }
+    catch (std::exception& e)
+    {
+      pars::err(SL, lf::app, "Error while running sharded application: {}",
+                e.what());
+
+      return EXIT_FAILURE;
+    }
+  }
+
+private:
+  static std::size_t default_num_shards()
+  {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  static std::vector<std::unique_ptr<ev::shard>>
+  make_shards(const std::size_t num_shards)
+  {
+    if (num_shards == 0)
+      throw std::invalid_argument("At least one shard is required!");
+
+    auto shards = std::vector<std::unique_ptr<ev::shard>>{};
+
+    for (auto i = std::size_t{0}; i < num_shards; ++i)
+      shards.push_back(std::make_unique<ev::shard>(i));
+
+    return shards;
+  }
+
+  std::vector<std::unique_ptr<ev::shard>> shards_m;
+  ev::enqueuer router_m;
+  component_type component_m;
+};
+
+} // namespace pars::app
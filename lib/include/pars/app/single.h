@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pars/ev/enqueuer.h"
 #include "pars/ev/hf_registry.h"
 #include "pars/ev/runner.h"
+#include "pars/ev/timer.h"
 #include "pars/log.h"
 
 namespace pars::app
@@ -50,6 +51,7 @@ public:
     : runner_m{hf_registry_m}
     , hf_registry_m{runner_m}
     , dispatcher_m{runner_m}
+    , timer_m{dispatcher_m}
     , router_m{dispatcher_m, runner_m}
     , component_m{hf_registry_m, router_m}
   {
@@ -73,6 +75,10 @@ protected:
 
   ev::hf_registry& hfs() { return hf_registry_m; }
 
+  ev::dispatcher& dispatcher() { return dispatcher_m; }
+
+  ev::timer& timers() { return timer_m; }
+
   virtual void startup(int argc, char** argv) = 0;
 
   void graceful_terminate()
@@ -109,6 +115,7 @@ private:
   ev::runner runner_m;
   ev::hf_registry hf_registry_m;
   ev::dispatcher dispatcher_m;
+  ev::timer timer_m;
   ev::enqueuer router_m;
   component_type component_m;
 };
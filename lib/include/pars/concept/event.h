@@ -37,16 +37,40 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 namespace pars::ev
 {
 
+/**
+ * @brief Where the handler of a kind_of<event_t> runs
+ *
+ * inline_io is only honored for sent and received events: their handler runs
+ * on the nng I/O thread that completed the operation, skipping the dispatcher
+ * queue. It is meant for tiny handlers (counters, forwarding, re-arming a
+ * receive) and comes with restrictions:
+ * - it must not block nor wait on other jobs, it delays every I/O completion
+ *   of nng meanwhile; debug builds warn when it runs for too long
+ * - it runs concurrently with dispatcher workers, strands and backpressure do
+ *   not apply
+ * - exceptions are processed as usual, on the I/O thread
+ *
+ * For any other kind it behaves like sync.
+ */
 enum class executes
 {
-  sync,
-  async
+  sync,     ///< on a dispatcher worker
+  async,    ///< on an async worker, with a stop_token
+  inline_io ///< on the nng I/O thread, see above
+};
+
+/// the dispatcher lane of an event, higher lanes are drained first
+enum class priority
+{
+  data,   ///< application events
+  control ///< pipe lifecycle, errors and shutdown
 };
 
 template<typename>
 struct klass;
 
-// event_t is an event if klass<event_t> meets these requirements
+// event_t is an event if klass<event_t> meets these requirements, the
+// scheduling traits are optional, see klass_traits
 template<typename event_t>
 concept event_c = requires {
   requires std::default_initializable<klass<event_t>>;
@@ -68,11 +92,19 @@ concept internal_event_c =
 template<typename event_t>
 concept network_event_c = event_c<event_t> && klass<event_t>::requires_network;
 
-// a synchronous event event_t requires sync exec_policy for kind_of
+// a synchronous event event_t requires sync or inline_io exec_policy for
+// kind_of
 template<typename event_t, template<typename> typename kind_of>
 concept sync_event_c =
   event_c<event_t> &&
-  klass<event_t>::template exec_policy<kind_of>() == executes::sync;
+  (klass<event_t>::template exec_policy<kind_of>() == executes::sync ||
+   klass<event_t>::template exec_policy<kind_of>() == executes::inline_io);
+
+// an inline event event_t requires inline_io exec_policy for kind_of
+template<typename event_t, template<typename> typename kind_of>
+concept inline_io_event_c =
+  event_c<event_t> &&
+  klass<event_t>::template exec_policy<kind_of>() == executes::inline_io;
 
 // a synchronous internal event event_t
 template<typename event_t, template<typename> typename kind_of>
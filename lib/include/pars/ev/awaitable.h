@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/ev/dispatcher.h"
+#include "pars/ev/task.h"
+#include "pars/net/op.h"
+
+#include <chrono>
+#include <coroutine>
+#include <stdexcept>
+
+namespace pars::ev
+{
+
+/**
+ * @brief The base of the awaitables of pars
+ *
+ * An awaitable suspends the coroutine handler on the dispatcher running it,
+ * then starts an operation whose completion resumes it there, by queueing
+ * fired<resumed> on the strand of the pipe of the job it suspended on.
+ * Completions resume it whatever their outcome, errors included.
+ */
+class resumable
+{
+public:
+  bool await_ready() const noexcept { return false; }
+
+protected:
+  /// remember where to resume h, that must run on a dispatcher worker
+  void suspend(std::coroutine_handle<> h)
+  {
+    dispatcher_m = dispatcher::current();
+
+    if (!dispatcher_m)
+      throw std::runtime_error(
+        "Only handlers running on a dispatcher worker can suspend!");
+
+    handle_m = h;
+
+    pipe_id_m = task_context::current().p_id;
+  }
+
+  /// queue the resumption, from any thread
+  ///
+  /// NOTE: the awaitable may be gone as soon as this is queued
+  void resume()
+  {
+    auto* d = dispatcher_m;
+
+    d->queue_back(fired{resumed{handle_m, pipe_id_m}, {}});
+  }
+
+private:
+  dispatcher* dispatcher_m{nullptr};
+  std::coroutine_handle<> handle_m;
+  int pipe_id_m{0};
+};
+
+/// suspends a coroutine handler on a net::op sleep, see sleep
+class sleep_awaitable : public resumable
+{
+public:
+  explicit sleep_awaitable(const std::chrono::milliseconds ms)
+    : ms_m{ms}
+  {
+  }
+
+  void await_suspend(std::coroutine_handle<> h)
+  {
+    suspend(h);
+
+    op_m.sleep_then(static_cast<nng_duration>(ms_m.count()),
+                    [this](clev::expected<void> res, nngxx::msg) {
+                      res_m = res;
+
+                      resume();
+                    });
+  }
+
+  /// an error if the sleep failed or was cancelled
+  clev::expected<void> await_resume() const { return res_m; }
+
+private:
+  std::chrono::milliseconds ms_m;
+  net::op op_m;
+  clev::expected<void> res_m;
+};
+
+/// co_await sleep(ms) suspends a coroutine handler for ms, resuming with the
+/// outcome
+[[nodiscard]] inline sleep_awaitable sleep(const std::chrono::milliseconds ms)
+{
+  return sleep_awaitable{ms};
+}
+
+} // namespace pars::ev
@@ -29,16 +29,30 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #pragma once
 
+#include "pars/ev/dispatcher_opt.h"
 #include "pars/ev/event.h"
 #include "pars/ev/hf_registry.h"
 #include "pars/ev/job.h"
 #include "pars/ev/kind.h"
+#include "pars/ev/mpsc_queue.h"
 #include "pars/ev/runner.h"
 #include "pars/log.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
+#include <limits>
+#include <map>
 #include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 namespace pars::ev
 {
@@ -49,46 +63,219 @@ public:
   dispatcher(runner& r)
     : runner_m{r}
   {
+    runner_m.set_on_completion([this]() { wake_reaper(); });
   }
 
-  /// @name Running Jobs
+  /// @name Options
 
-  void run()
+  void set_options(const dispatcher_opt opts)
   {
-    running_m = true;
+    auto guard = std::lock_guard{mtx_m};
 
-    queue_back(fired{init{}, {}});
+    if (running_m)
+      throw std::runtime_error("Unable to set options while running!");
 
-    for (;;)
+    if (opts.num_workers)
     {
-      auto lock = std::unique_lock{mtx_m};
+      if (*opts.num_workers == 0)
+        throw std::invalid_argument("At least one worker is required!");
 
-      cond_m.wait(lock, [&]() { return !queue_m.empty() || !running_m; });
+      num_workers_m = *opts.num_workers;
+    }
 
-      if (!running_m)
-      {
-        cond_m.wait(lock, [&]() { return terminate_m; });
+    if (opts.batch_size)
+    {
+      if (*opts.batch_size == 0)
+        throw std::invalid_argument("Batch size must be at least one!");
 
-        return;
-      }
+      batch_size_m = *opts.batch_size;
+    }
 
-      // NOTE: exec is executed after mtx_m unlock
+    if (opts.control_burst)
+    {
+      if (*opts.control_burst == 0)
+        throw std::invalid_argument("Control burst must be at least one!");
 
-      runner_m.exec(next_job(lock));
+      control_burst_m = *opts.control_burst;
     }
+
+    if (opts.fair_quantum)
+      fair_quantum_m = *opts.fair_quantum;
+
+    if (opts.idle_spins)
+      idle_spins_m = *opts.idle_spins;
+
+    if (opts.idle_yields)
+      idle_yields_m = *opts.idle_yields;
+
+    if (opts.num_async_workers)
+      runner_m.set_num_async_workers(*opts.num_async_workers);
+
+    if (opts.worker_placement)
+    {
+      opts.worker_placement->validate();
+
+      worker_placement_m = *opts.worker_placement;
+    }
+
+    if (opts.async_worker_placement)
+      runner_m.set_async_placement(*opts.async_worker_placement);
+
+    set_watermarks(high_jobs_m, low_jobs_m, opts.high_watermark_jobs,
+                   opts.low_watermark_jobs);
+
+    set_watermarks(high_bytes_m, low_bytes_m, opts.high_watermark_bytes,
+                   opts.low_watermark_bytes);
+
+    if (opts.decode_on_receive)
+      decode_on_receive_m = *opts.decode_on_receive;
+
+    if (opts.shed_interval && opts.shed_interval->count() <= 0)
+      throw std::invalid_argument("Shed interval must be positive!");
+
+    if (opts.shed_target)
+      shed_target_m = *opts.shed_target;
+
+    if (opts.shed_interval)
+      shed_interval_m = *opts.shed_interval;
+
+    if (opts.edf)
+      edf_m = *opts.edf;
   }
 
-  void stop_running()
+  dispatcher_opt options()
   {
     auto guard = std::lock_guard{mtx_m};
 
-    queue_m.clear();
+    return {.num_workers = num_workers_m,
+            .batch_size = batch_size_m,
+            .control_burst = control_burst_m,
+            .fair_quantum = fair_quantum_m,
+            .idle_spins = idle_spins_m,
+            .idle_yields = idle_yields_m,
+            .num_async_workers = runner_m.num_async_workers(),
+            .worker_placement = worker_placement_m,
+            .async_worker_placement = runner_m.async_placement(),
+            .high_watermark_jobs = high_jobs_m,
+            .low_watermark_jobs = low_jobs_m,
+            .high_watermark_bytes = high_bytes_m,
+            .low_watermark_bytes = low_bytes_m,
+            .decode_on_receive = decode_on_receive_m,
+            .shed_target = shed_target_m,
+            .shed_interval = shed_interval_m,
+            .edf = edf_m};
+  }
+
+  /// @name Running Jobs
+
+  /// run jobs on the calling thread plus num_workers - 1 additional threads,
+  /// returns after terminate_now
+  ///
+  /// the calling thread is placed as the first worker, see worker_placement,
+  /// it gets its name and its CPUs back once run returns
+  ///
+  /// only the dispatcher that starts the application fires init, secondary
+  /// ones (eg: the shards of app::sharded) run with fire_init = false
+  void run(const bool fire_init = true)
+  {
+    {
+      auto guard = std::lock_guard{mtx_m};
+
+      running_m = true;
+    }
+
+    if (fire_init)
+      queue_back(fired{init{}, {}});
+
+    auto workers = std::vector<std::jthread>{};
+
+    for (auto i = std::size_t{1}; i < num_workers_m; ++i)
+      workers.emplace_back([this, i]() { work(i); });
+
+    auto restore = placement_guard{};
+
+    work(0);
+  }
+
+  /// stop running jobs, waiting for async jobs to complete
+  ///
+  /// NOTE: async jobs are joined without holding mtx_m, they may be queueing
+  /// (eg: queue_front) while stopping; whatever they queue is dropped
+  ///
+  /// the jobs dropped are released as if executed, a restart begins from no
+  /// pending job and receives deferred while congested are re-armed
+  void stop_running()
+  {
+    {
+      auto guard = std::lock_guard{mtx_m};
+
+      running_m = false;
+
+      cond_m.notify_all();
+    }
 
     runner_m.stop_all_threads();
 
-    running_m = false;
+    auto num_dropped = std::size_t{0};
+    auto bytes = std::size_t{0};
 
-    cond_m.notify_one();
+    auto drop = [&](const job& j) {
+      ++num_dropped;
+
+      bytes += j.bytes();
+    };
+
+    {
+      auto guard = std::lock_guard{mtx_m};
+
+      for (auto& lane : lanes_m)
+        while (auto j = lane.try_pop())
+          drop(*j);
+
+      std::ranges::for_each(urgent_m, drop);
+
+      urgent_m.clear();
+
+      num_urgent_m = 0;
+
+      for (const auto& [p_id, f] : flows_m)
+        std::ranges::for_each(f.jobs, drop);
+
+      flows_m.clear();
+
+      active_flows_m.clear();
+
+      std::ranges::for_each(edf_heap_m, drop);
+
+      edf_heap_m.clear();
+
+      num_held_m = 0;
+
+      above_target_since_m = {};
+
+      shedding_m = false;
+
+      std::ranges::for_each(ready_m, drop);
+
+      ready_m.clear();
+
+      num_ready_m = 0;
+
+      for (const auto& [p_id, parked] : strands_m)
+        std::ranges::for_each(parked, drop);
+
+      strands_m.clear();
+
+      {
+        auto conflated_guard = std::lock_guard{conflated_mtx_m};
+
+        conflated_m.clear();
+      }
+    }
+
+    // NOTE: deferred_mtx_m is never taken while holding mtx_m
+    if (num_dropped > 0)
+      executed(bytes, num_dropped);
   }
 
   void terminate_now()
@@ -100,71 +287,934 @@ public:
 
     terminate_m = true;
 
-    cond_m.notify_one();
+    cond_m.notify_all();
   }
 
-  bool terminating()
+  bool terminating() const { return running_m == false; }
+
+  /// the dispatcher running jobs on the calling thread, if any
+  static dispatcher* current() { return current_m; }
+
+  /// the shard whose jobs run here, see this_shard
+  void set_shard(const std::size_t shard_idx)
   {
     auto guard = std::lock_guard{mtx_m};
 
-    return running_m == false;
+    if (running_m)
+      throw std::runtime_error("Unable to set the shard while running!");
+
+    shard_m = shard_idx;
   }
 
   /// @name Managing Queue
 
+  /// lock-free, producers (nng callbacks, async jobs, handlers) never contend
+  /// on mtx_m unless a worker is sleeping and the spinning ones are too few
   template<template<typename> typename kind_of, event_c event_t>
     requires kind_c<kind_of>
   void queue_back(kind_of<event_t> ke)
   {
-    auto guard = std::lock_guard{mtx_m};
-
     queue(std::move(ke),
-          std::bind(std::mem_fn<void(decltype(queue_m)::value_type&&)>(
-                      &decltype(queue_m)::push_back),
-                    &queue_m, std::placeholders::_1));
+          [this](job&& j) { lane(j.priority()).push(std::move(j)); });
+
+    wake_worker();
   }
 
+  /// urgent jobs are rare, they're kept in a deque guarded by mtx_m
   template<template<typename> typename kind_of, event_c event_t>
     requires kind_c<kind_of>
   void queue_front(kind_of<event_t> ke)
   {
+    if (!running_m)
+      return;
+
     auto guard = std::lock_guard{mtx_m};
 
     queue(std::move(ke),
-          std::bind(std::mem_fn<void(decltype(queue_m)::value_type&&)>(
-                      &decltype(queue_m)::push_front),
-                    &queue_m, std::placeholders::_1));
+          std::bind(std::mem_fn<void(decltype(urgent_m)::value_type&&)>(
+                      &decltype(urgent_m)::push_front),
+                    &urgent_m, std::placeholders::_1));
+
+    num_urgent_m = urgent_m.size();
+
+    cond_m.notify_one();
+  }
+
+  /// data jobs dropped unexecuted because their pipe was removed
+  std::size_t num_purged() const { return num_purged_m; }
+
+  /// @name Conflation
+
+  /// jobs replaced, before running, by a newer one with the same conflation
+  /// key, see klass::conflated
+  std::size_t num_conflated() const { return num_conflated_m; }
+
+  /// @name Load Shedding
+
+  /// whether droppable jobs are shed, see dispatcher_opt::shed_target
+  bool shedding() const { return shedding_m; }
+
+  /// droppable jobs shed so far
+  std::size_t num_shed() const { return num_shed_m; }
+
+  /// @name Deadlines
+
+  /// jobs taken past their deadline so far, see dispatcher_opt::edf
+  std::size_t num_expired() const { return num_expired_m; }
+
+  /// @name Backpressure
+
+  /// whether jobs not yet executed crossed an high watermark and are not yet
+  /// below the low ones
+  bool congested() const { return congested_m; }
+
+  /// run f once not congested anymore, returns false without running f if not
+  /// congested; a new f for the same key replaces the previous one
+  bool defer_while_congested(const void* key, std::move_only_function<void()> f)
+  {
+    auto guard = std::lock_guard{deferred_mtx_m};
+
+    if (!congested_m)
+      return false;
+
+    deferred_m.insert_or_assign(key, std::move(f));
+
+    return true;
+  }
+
+  /// drop what was deferred for key, waiting for it if it's running
+  void cancel_deferred(const void* key)
+  {
+    auto guard = std::lock_guard{deferred_mtx_m};
+
+    deferred_m.erase(key);
+  }
+
+  /// @name Recycling
+
+  /// how much of the memory of jobs is recycled, to size the pools for the
+  /// steady state
+  struct recycling
+  {
+    pool_stats jobs;         ///< queued jobs, across lanes
+    pool_stats async_frames; ///< running async jobs
+    pool_stats completions;  ///< completed async jobs, not yet reaped
+  };
+
+  recycling recycled() const
+  {
+    auto r = recycling{.jobs = {},
+                       .async_frames = runner_m.frame_stats(),
+                       .completions = runner_m.completion_stats()};
+
+    for (const auto& lane : lanes_m)
+      r.jobs += lane.node_stats();
+
+    return r;
   }
 
 private:
   /// @name Multi Threading
 
-  std::mutex mtx_m;
+  std::mutex mtx_m; ///< guards everything but lanes_m producers side
   std::condition_variable cond_m;
+  std::atomic<std::size_t> sleeping_m{0}; ///< workers waiting on cond_m
+  std::atomic<std::size_t> spinning_m{0}; ///< workers polling the queue
+  std::size_t idle_spins_m{0};            ///< polls busy-spinning
+  std::size_t idle_yields_m{0};           ///< polls yielding the CPU
 
-  /// @name Running Jobs
+  /// notify a sleeping worker, if any, unless the spinning ones are enough
+  /// to take every queued job, each one takes a job before spinning again
+  ///
+  /// NOTE: a worker announces itself in sleeping_m before checking the queue
+  /// for the last time, so either it sees the job or we see it sleeping; it
+  /// stops spinning only before that check, so a spinning one sees it too.
+  /// Both sides store then load, that takes a full fence on each: the lane
+  /// push is a release store, it may be reordered after the sleeping_m load
+  void wake_worker()
+  {
+    // pairs with the fence of wait_job
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (sleeping_m.load() == 0 || !running_m)
+      return;
+
+    if (num_queued() <= spinning_m.load())
+      return;
+
+    // the worker releases mtx_m only once it's waiting on cond_m
+    {
+      auto guard = std::lock_guard{mtx_m};
+    }
 
-  job next_job(auto& lock)
+    cond_m.notify_one();
+  }
+
+  /// notify a sleeping worker, if any, to reap the completion records left
+  /// by async jobs: with no job queued, nobody would exec and reap them
+  ///
+  /// NOTE: same handshake as wake_worker, the record is pushed before
+  void wake_reaper()
   {
-    auto j{std::move(queue_m.front())};
+    // pairs with the fence of wait_job
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (sleeping_m.load() == 0 || !running_m)
+      return;
+
+    {
+      auto guard = std::lock_guard{mtx_m};
+    }
+
+    cond_m.notify_one();
+  }
+
+  /// wait for the next job to execute, or nullopt if not running anymore
+  ///
+  /// while waiting, completion records of async jobs are reaped, their
+  /// exceptions are processed on this worker
+  std::optional<job> wait_job(std::unique_lock<std::mutex>& lock)
+  {
+    for (;;)
+    {
+      if (!running_m)
+        return std::nullopt;
+
+      if (auto j = next_job())
+        return j;
+
+      if (runner_m.has_completions())
+      {
+        lock.unlock();
+
+        runner_m.reap_completions();
+
+        lock.lock();
+
+        continue;
+      }
 
-    queue_m.pop_front();
+      if (spin_for_job(lock))
+        continue;
 
-    // we would like to use exec(next_job(std::move(lock)))
-    // but it is implementation-defined wether the lock moved into next_job
-    // is destroyed before exec is executed or not
-    // https://eel.is/c++draft/expr.call#6.sentence-10
+      sleeping_m.fetch_add(1);
+
+      // pairs with the fence of wake_worker and wake_reaper
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      auto j = next_job();
+
+      if (!j && running_m && !runner_m.has_completions())
+        cond_m.wait(lock);
+
+      sleeping_m.fetch_sub(1);
+
+      if (j)
+        return j;
+    }
+  }
+
+  /// poll the queue without holding mtx_m, busy-spinning then yielding,
+  /// returns whether a job may be there
+  ///
+  /// NOTE: jobs handed over by release_strand are guarded by mtx_m, spinning
+  /// workers see them through num_ready_m
+  bool spin_for_job(std::unique_lock<std::mutex>& lock)
+  {
+    if (idle_spins_m == 0 && idle_yields_m == 0)
+      return false;
+
+    spinning_m.fetch_add(1);
 
-    // for this reason, we are going to unlock here
     lock.unlock();
 
+    auto found = false;
+
+    for (auto i = std::size_t{0}; !found && i < idle_spins_m + idle_yields_m;
+         ++i)
+    {
+      if (i < idle_spins_m)
+        cpu_relax();
+      else
+        std::this_thread::yield();
+
+      found = !running_m || num_urgent_m.load() > 0 ||
+              num_ready_m.load() > 0 || num_queued() > 0 ||
+              runner_m.has_completions();
+    }
+
+    lock.lock();
+
+    spinning_m.fetch_sub(1);
+
+    return found;
+  }
+
+  /// @name Running Jobs
+
+  void work(const std::size_t idx)
+  {
+    place_this_thread(worker_placement_m, idx);
+
+    current_m = this;
+
+    this_shard() = shard_m;
+
+    // reused, taking a batch doesn't allocate
+    auto batch = std::vector<job>{};
+
+    batch.reserve(batch_size_m);
+
+    for (;;)
+    {
+      auto lock = std::unique_lock{mtx_m};
+
+      auto j = wait_job(lock);
+
+      if (!j)
+      {
+        cond_m.wait(lock, [&]() { return terminate_m; });
+
+        current_m = nullptr;
+
+        this_shard() = std::nullopt;
+
+        return;
+      }
+
+      batch.push_back(std::move(*j));
+
+      fill_batch(batch);
+
+      // NOTE: jobs are executed after mtx_m unlock
+
+      lock.unlock();
+
+      auto next = std::size_t{0};
+
+      while (next < batch.size())
+      {
+        // the rest of the batch is dropped, see stop_running
+        if (!running_m)
+        {
+          drop_batch(std::span{batch}.subspan(next));
+
+          break;
+        }
+
+        // jobs queued at the front overtake the rest of the batch
+        if (auto u = num_urgent_m.load() > 0 ? next_urgent_job() : std::nullopt)
+        {
+          execute(std::move(*u));
+
+          continue;
+        }
+
+        execute(std::move(batch[next++]));
+      }
+
+      batch.clear();
+    }
+  }
+
+  /// take more jobs while holding mtx_m, up to batch_size_m, leaving a fair
+  /// share of the pending ones to the other workers
+  void fill_batch(std::vector<job>& batch)
+  {
+    auto limit = batch_size_m;
+
+    if (num_workers_m > 1)
+      limit = std::min(limit, num_queued() / num_workers_m + 1);
+
+    while (batch.size() < limit)
+    {
+      auto j = next_job();
+
+      if (!j)
+        break;
+
+      batch.push_back(std::move(*j));
+    }
+  }
+
+  /// release the strands and the pending counts of jobs left unexecuted
+  void drop_batch(std::span<const job> dropped)
+  {
+    auto bytes = std::size_t{0};
+
+    for (const auto& j : dropped)
+    {
+      if (strands_enabled() && j.pipe_id() > 0)
+        release_strand(j.pipe_id());
+
+      bytes += j.bytes();
+    }
+
+    executed(bytes, dropped.size());
+  }
+
+  std::optional<job> next_urgent_job()
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    while (!urgent_m.empty())
+    {
+      auto j{std::move(urgent_m.front())};
+
+      urgent_m.pop_front();
+
+      num_urgent_m = urgent_m.size();
+
+      if (acquire_strand(j))
+        return j;
+    }
+
+    return std::nullopt;
+  }
+
+  void execute(job&& j)
+  {
+    if (j.conflation_key())
+      take_latest(j);
+
+    auto p_id = j.pipe_id();
+    auto bytes = j.bytes();
+
+    if (purgeable(j))
+    {
+      pars::debug(SL, lf::event, "Job #{}: Pipe {:X} removed, purged!", j.id(),
+                  p_id);
+
+      ++num_purged_m;
+    }
+    else if (edf_m && std::chrono::steady_clock::now() > j.deadline())
+      expire(std::move(j));
+    else if (shedding_m && droppable(j))
+      shed(std::move(j));
+    else
+      runner_m.exec(std::move(j));
+
+    if (strands_enabled() && p_id > 0)
+      release_strand(p_id);
+
+    executed(bytes);
+  }
+
+  /// a queued data job of a removed pipe is a tombstone: the stale key of its
+  /// pipe tells in O(1), without locking; pipes are added on creating_pipe,
+  /// an unknown one was removed before its job was queued. Control jobs run
+  /// anyway, eg: pipe_created is seen by handlers before pipe_removed
+  bool purgeable(const job& j)
+  {
+    return j.priority() == priority::data && j.pipe_id() > 0 &&
+           !j.pipe_alive();
+  }
+
+  /// NOTE: called with mtx_m held, that makes workers a single consumer
+  std::optional<job> next_job()
+  {
+    for (auto* q : {&ready_m, &urgent_m})
+    {
+      if (!q->empty())
+      {
+        auto j{std::move(q->front())};
+
+        q->pop_front();
+
+        num_urgent_m = urgent_m.size();
+
+        num_ready_m = ready_m.size();
+
+        if (q == &ready_m || acquire_strand(j))
+          return j;
+      }
+    }
+
+    // higher lanes first, unless the data lane waited control_burst_m jobs
+    auto order = std::array{priority::control, priority::data};
+
+    if (control_streak_m >= control_burst_m)
+      std::swap(order[0], order[1]);
+
+    for (auto prio : order)
+    {
+      while (auto j = pop(prio))
+      {
+        if (prio == priority::control)
+          ++control_streak_m;
+        else
+        {
+          control_streak_m = 0;
+
+          watch_sojourn(*j);
+        }
+
+        if (acquire_strand(*j))
+          return j;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  std::optional<job> pop(const priority prio)
+  {
+    if (prio == priority::data && edf_m)
+      return next_edf_job();
+
+    if (prio == priority::data && fair_quantum_m > 0)
+      return next_fair_job();
+
+    return lane(prio).try_pop();
+  }
+
+  /// @name Fair Queuing
+  ///
+  /// Deficit round robin across the flows of data jobs, one per pipe id plus
+  /// one for internal events (pipe id 0): a pipe flooding the dispatcher only
+  /// delays its own jobs. Every round a flow gets fair_quantum_m bytes of
+  /// credit, and spends it running jobs costing the size of their message.
+
+  /// jobs without a message cost as if they had one this size
+  static constexpr std::size_t fair_min_cost = 64;
+
+  struct flow
+  {
+    std::deque<job> jobs;
+    std::size_t deficit{0}; ///< credit left in this round
+    bool in_turn{false};    ///< got the quantum of this round already
+  };
+
+  /// NOTE: called with mtx_m held
+  std::optional<job> next_fair_job()
+  {
+    while (auto j = lane(priority::data).try_pop())
+    {
+      auto p_id = j->pipe_id();
+
+      auto& f = flows_m[p_id];
+
+      if (f.jobs.empty())
+        active_flows_m.push_back(p_id);
+
+      f.jobs.push_back(std::move(*j));
+
+      ++num_held_m;
+    }
+
+    while (!active_flows_m.empty())
+    {
+      auto p_id = active_flows_m.front();
+
+      auto& f = flows_m[p_id];
+
+      if (!f.in_turn)
+      {
+        f.deficit += fair_quantum_m;
+
+        f.in_turn = true;
+      }
+
+      auto cost = std::max(f.jobs.front().bytes(), fair_min_cost);
+
+      // not enough credit, try again next round
+      if (cost > f.deficit)
+      {
+        f.in_turn = false;
+
+        active_flows_m.pop_front();
+
+        active_flows_m.push_back(p_id);
+
+        continue;
+      }
+
+      f.deficit -= cost;
+
+      auto j = std::optional<job>{std::move(f.jobs.front())};
+
+      f.jobs.pop_front();
+
+      --num_held_m;
+
+      // an idle flow does not keep its credit
+      if (f.jobs.empty())
+      {
+        active_flows_m.pop_front();
+
+        flows_m.erase(p_id);
+      }
+
+      return j;
+    }
+
+    return std::nullopt;
+  }
+
+  std::size_t fair_quantum_m{0};         ///< 0 for FIFO
+  std::unordered_map<int, flow> flows_m; ///< data jobs taken from their lane
+  std::deque<int> active_flows_m;        ///< pipe ids of flows with jobs
+  std::atomic<std::size_t> num_held_m{0}; ///< jobs in flows_m or edf_m
+
+  /// @name Load Shedding
+  ///
+  /// Like CoDel, the queue is judged by how long jobs wait in it, not by its
+  /// length: a burst draining quickly is fine, a standing queue is not. Since
+  /// shedding here means a cheap rejection, not a signal to a sender, every
+  /// droppable job is shed while above target.
+
+  /// NOTE: called with mtx_m held, for every data job taken
+  void watch_sojourn(const job& j)
+  {
+    if (shed_target_m.count() == 0)
+      return;
+
+    auto now = std::chrono::steady_clock::now();
+
+    if (now - j.queued_at() < shed_target_m)
+    {
+      above_target_since_m = {};
+
+      shedding_m = false;
+
+      return;
+    }
+
+    if (above_target_since_m == std::chrono::steady_clock::time_point{})
+      above_target_since_m = now;
+    else if (!shedding_m && now - above_target_since_m >= shed_interval_m)
+    {
+      pars::warn(SL, lf::event, "Overloaded, shedding droppable jobs!");
+
+      shedding_m = true;
+    }
+  }
+
+  bool droppable(const job& j) const
+  {
+    auto info = runner_m.info_for(j.spec_hash());
+
+    return info && info->droppable;
+  }
+
+  /// run the handler of fired<overloaded> in place of the one of j, if any
+  void shed(job&& j)
+  {
+    auto sojourn = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - j.queued_at());
+
+    ++num_shed_m;
+
+    pars::debug(SL, lf::event, "Job #{}: shed after {}us!", j.id(),
+                sojourn.count());
+
+    run_instead(j, overloaded{j.spec_hash(), sojourn});
+  }
+
+  /// run the handler of fired<event_t> in place of the one of j, with the
+  /// metadata of j; only for network jobs, that have somewhere to reply to
+  template<network_event_c event_t>
+  void run_instead(job& j, event_t ev)
+  {
+    auto info = runner_m.info_for(j.spec_hash());
+
+    if (!info || !info->network_md)
+      return;
+
+    auto md = info->network_md(j);
+
+    if (runner_m.can_exec(md.socket_id(), spec<fired<event_t>>::hash))
+      runner_m.exec(
+        fired{std::move(ev), {md.socket_id(), md.tool(), md.pipe()}});
+  }
+
+  /// @name Deadlines
+  ///
+  /// In EDF mode data jobs are taken earliest deadline first, jobs without
+  /// one last, ties in queueing order; a job taken past its deadline fires
+  /// expired instead of running.
+
+  /// the time j is queued at, and its deadline if any
+  template<template<typename> typename kind_of, event_c event_t>
+  void stamp(job& j)
+  {
+    auto now = std::chrono::steady_clock::now();
+
+    j.set_queued_at(now);
+
+    // the event of a received message is known only at runtime
+    auto budget = klass_traits<event_t>::deadline;
+
+    if constexpr (std::is_same_v<kind_of<event_t>, received<nngxx::msg>>)
+    {
+      if (auto info = runner_m.info_for(j.spec_hash()))
+        budget = info->deadline;
+    }
+
+    if (budget.count() > 0)
+      j.set_deadline(now + budget);
+  }
+
+  /// NOTE: called with mtx_m held
+  std::optional<job> next_edf_job()
+  {
+    // a max heap of the latest deadline, is a min heap of the earliest
+    auto later = [](const job& a, const job& b) {
+      return a.deadline() != b.deadline() ? a.deadline() > b.deadline()
+                                          : a.id() > b.id();
+    };
+
+    while (auto j = lane(priority::data).try_pop())
+    {
+      edf_heap_m.push_back(std::move(*j));
+
+      std::push_heap(edf_heap_m.begin(), edf_heap_m.end(), later);
+
+      ++num_held_m;
+    }
+
+    if (edf_heap_m.empty())
+      return std::nullopt;
+
+    std::pop_heap(edf_heap_m.begin(), edf_heap_m.end(), later);
+
+    auto j = std::optional<job>{std::move(edf_heap_m.back())};
+
+    edf_heap_m.pop_back();
+
+    --num_held_m;
+
     return j;
   }
 
-  bool terminate_m{false}; ///< terminate run and exit
-  bool running_m{false};   ///< wether we're running jobs
+  /// run the handler of fired<expired> in place of the one of j, if any
+  void expire(job&& j)
+  {
+    auto late = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - j.deadline());
+
+    ++num_expired_m;
+
+    pars::debug(SL, lf::event, "Job #{}: expired {}us late!", j.id(),
+                late.count());
+
+    run_instead(j, expired{j.spec_hash(), late});
+  }
+
+  bool edf_m{false};           ///< take data jobs earliest deadline first
+  std::vector<job> edf_heap_m; ///< data jobs taken from their lane
+  std::atomic<std::size_t> num_expired_m{0};
+
+  std::chrono::microseconds shed_target_m{0}; ///< 0 never sheds
+  std::chrono::microseconds shed_interval_m{std::chrono::milliseconds{100}};
+  std::chrono::steady_clock::time_point
+    above_target_since_m; ///< first job above target in a row, if any
+  std::atomic<bool> shedding_m{false};
+  std::atomic<std::size_t> num_shed_m{0};
+
+  static inline thread_local dispatcher* current_m{nullptr};
+  std::optional<std::size_t> shard_m; ///< set by shard, if any
+
+  thread_placement worker_placement_m; ///< of the threads executing jobs
+
+  std::size_t num_workers_m{1};       ///< threads executing jobs
+  std::size_t batch_size_m{64};       ///< max jobs taken at once
+  std::size_t control_burst_m{32};    ///< control jobs before a data one
+  std::size_t control_streak_m{0};    ///< control jobs taken in a row
+  bool decode_on_receive_m{false};    ///< decode in queue, not in execute
+  bool terminate_m{false};            ///< terminate run and exit
+  std::atomic<bool> running_m{false}; ///< wether we're running jobs
   runner& runner_m;
 
+  /// @name Backpressure
+
+  static void set_watermarks(std::size_t& high, std::size_t& low,
+                             const std::optional<std::size_t> opt_high,
+                             const std::optional<std::size_t> opt_low)
+  {
+    auto new_high = opt_high.value_or(high);
+    auto new_low = opt_low.value_or(opt_high ? new_high / 2 : low);
+
+    if (new_low > new_high)
+      throw std::invalid_argument(
+        "Low watermark must not exceed the high one!");
+
+    high = new_high;
+    low = new_low;
+  }
+
+  /// a job was queued, from any thread
+  void queued(const std::size_t bytes)
+  {
+    auto jobs = pending_jobs_m.fetch_add(1) + 1;
+    auto total = pending_bytes_m.fetch_add(bytes) + bytes;
+
+    if (!congested_m && (jobs >= high_jobs_m || total >= high_bytes_m))
+    {
+      congested_m = true;
+
+      pars::warn(SL, lf::event, "Congested, pausing receives [# jobs: {}]",
+                 jobs);
+    }
+  }
+
+  /// n jobs were executed, or dropped, resume what was deferred once below the
+  /// low marks
+  void executed(const std::size_t bytes, const std::size_t n = 1)
+  {
+    auto jobs = pending_jobs_m.fetch_sub(n) - n;
+    auto total = pending_bytes_m.fetch_sub(bytes) - bytes;
+
+    if (congested_m && jobs <= low_jobs_m && total <= low_bytes_m &&
+        congested_m.exchange(false))
+    {
+      pars::info(SL, lf::event, "Not congested, resuming receives");
+
+      resume_deferred();
+    }
+  }
+
+  void resume_deferred()
+  {
+    auto guard = std::lock_guard{deferred_mtx_m};
+
+    for (auto& [key, f] : deferred_m)
+      f();
+
+    deferred_m.clear();
+  }
+
+  std::size_t high_jobs_m{std::numeric_limits<std::size_t>::max()};
+  std::size_t low_jobs_m{std::numeric_limits<std::size_t>::max()};
+  std::size_t high_bytes_m{std::numeric_limits<std::size_t>::max()};
+  std::size_t low_bytes_m{std::numeric_limits<std::size_t>::max()};
+  std::atomic<std::size_t> pending_jobs_m{0};  ///< queued, not executed yet
+  std::atomic<std::size_t> pending_bytes_m{0}; ///< bytes of pending messages
+  std::atomic<bool> congested_m{false};        ///< above an high watermark
+  std::mutex deferred_mtx_m; ///< NOTE: never taken while holding mtx_m
+  std::unordered_map<const void*, std::move_only_function<void()>>
+    deferred_m; ///< what to run once not congested anymore
+
+  /// @name Strands
+
+  /// with a single worker jobs are already executed in FIFO order
+  bool strands_enabled() const { return num_workers_m > 1; }
+
+  /// take ownership of the strand of j, or park j behind the job that owns it
+  bool acquire_strand(job& j)
+  {
+    auto p_id = j.pipe_id();
+
+    if (!strands_enabled() || p_id <= 0)
+      return true;
+
+    auto [it, acquired] = strands_m.try_emplace(p_id);
+
+    if (!acquired)
+    {
+      pars::debug(SL, lf::event, "Job #{} parked on the strand of Pipe {:X}",
+                  j.id(), p_id);
+
+      it->second.push_back(std::move(j));
+    }
+
+    return acquired;
+  }
+
+  /// hand the strand over to the next parked job, if any, or release it
+  void release_strand(const int p_id)
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    auto it = strands_m.find(p_id);
+
+    // the strand was dropped by stop_running
+    if (it == strands_m.end())
+      return;
+
+    auto& parked = it->second;
+
+    if (parked.empty())
+    {
+      strands_m.erase(it);
+
+      return;
+    }
+
+    ready_m.push_back(std::move(parked.front()));
+
+    num_ready_m = ready_m.size();
+
+    parked.pop_front();
+
+    cond_m.notify_one();
+  }
+
+  std::deque<job> ready_m; ///< parked jobs that already own their strand
+  std::atomic<std::size_t> num_ready_m{0}; ///< ready_m size, read unlocked
+  std::unordered_map<int, std::deque<job>>
+    strands_m; ///< jobs parked behind the running job of a given pipe id
+
+  /// @name Conflation
+  ///
+  /// Only the first job of a conflation key is queued, the newer ones wait
+  /// aside replacing each other; the newest runs in place of the first.
+
+  /// the spec, the pipe id and the conflation key of a conflated job
+  using conflation = std::tuple<std::size_t, int, std::size_t>;
+
+  static conflation conflation_of(const job& j)
+  {
+    return {j.spec_hash(), j.pipe_id(), *j.conflation_key()};
+  }
+
+  /// set aside j if a job with its conflation key is queued, returns false if
+  /// j is the first one and must be queued
+  ///
+  /// NOTE: conflated jobs carry no message bytes, replacing one leaves the
+  /// backpressure accounting as is
+  bool conflate(job& j, const std::size_t key)
+  {
+    j.set_conflation_key(key);
+
+    auto guard = std::lock_guard{conflated_mtx_m};
+
+    auto [it, first] = conflated_m.try_emplace(conflation_of(j));
+
+    if (first)
+      return false;
+
+    pars::debug(SL, lf::event, "Job #{} conflated [key: {}]", j.id(), key);
+
+    it->second.emplace(std::move(j));
+
+    ++num_conflated_m;
+
+    return true;
+  }
+
+  /// j is the first job of its conflation key, the newest one runs instead
+  void take_latest(job& j)
+  {
+    auto guard = std::lock_guard{conflated_mtx_m};
+
+    auto it = conflated_m.find(conflation_of(j));
+
+    // dropped by stop_running
+    if (it == conflated_m.end())
+      return;
+
+    if (it->second)
+      j = std::move(*it->second);
+
+    conflated_m.erase(it);
+  }
+
+  std::mutex conflated_mtx_m; ///< NOTE: never held while taking mtx_m
+  std::map<conflation, std::optional<job>>
+    conflated_m; ///< conflation keys queued, with their newest job if any
+  std::atomic<std::size_t> num_conflated_m{0};
+
   /// @name Managing Queue
 
   template<template<typename> typename kind_of, event_c event_t>
@@ -174,30 +1224,83 @@ private:
     if (!running_m)
       return;
 
-    auto j_id = runner_m.next_job_id();
+    // NOTE: taken before ke is moved into its job
+    auto c_key = std::optional<std::size_t>{};
 
-    push_fn(make_job(j_id, std::move(ke)));
+    if constexpr (klass_traits<event_t>::conflated)
+      c_key = klass_traits<event_t>::conflation_key(ke.event());
+
+    auto j_id = runner_m.next_job_id();
 
     if constexpr (internal_event_c<event_t>)
     {
+      auto j = make_job(j_id, std::move(ke));
+
+      stamp<kind_of, event_t>(j);
+
+      if (c_key && conflate(j, *c_key))
+        return;
+
+      queued(j.bytes());
+
+      push_fn(std::move(j));
+
       pars::debug(SL, lf::event, "Job #{} pushed [# jobs: {}]", j_id,
-                  queue_m.size());
+                  num_queued());
     }
     else if constexpr (network_event_c<event_t>)
     {
       auto p_id = ke.md().pipe().id();
 
-      runner_m.associate_job_to_pipe(j_id, p_id);
+      // NOTE: associate before pushing, a worker may pop the job right away
+      auto p_key = runner_m.associate_job_to_pipe(j_id, p_id);
+
+      auto j = make_job(j_id, std::move(ke));
+
+      j.set_pipe_key(p_key);
+
+      // decoding on the producer thread leaves workers the handler only
+      if constexpr (std::is_same_v<kind_of<event_t>, received<nngxx::msg>>)
+      {
+        if (decode_on_receive_m)
+          runner_m.decode(j);
+      }
+
+      stamp<kind_of, event_t>(j);
+
+      if (c_key && conflate(j, *c_key))
+        return;
+
+      queued(j.bytes());
+
+      push_fn(std::move(j));
 
       pars::debug(SL, lf::event,
                   "Job #{} pushed and associated with Pipe {:X} [# jobs: {}]",
-                  j_id, p_id, queue_m.size());
+                  j_id, p_id, num_queued());
     }
+  }
 
-    cond_m.notify_one();
+  /// the lane of the jobs with priority prio
+  mpsc_queue<job>& lane(const priority prio)
+  {
+    return lanes_m[static_cast<std::size_t>(prio)];
+  }
+
+  std::size_t num_queued() const
+  {
+    auto n = std::size_t{0};
+
+    for (const auto& lane : lanes_m)
+      n += lane.size();
+
+    return n + num_held_m;
   }
 
-  std::deque<job> queue_m; ///< a deque of all jobs
+  std::array<mpsc_queue<job>, 2> lanes_m;   ///< jobs queued at the back
+  std::deque<job> urgent_m;                 ///< jobs queued at the front
+  std::atomic<std::size_t> num_urgent_m{0}; ///< urgent_m size, read unlocked
+  std::atomic<std::size_t> num_purged_m{0}; ///< tombstones dropped so far
 };
 
 } // namespace pars::ev
@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/ev/threading.h"
+#include "pars/init.h"
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace pars::ev
+{
+
+/**
+ * @brief Represents the options that can be configured for a dispatcher
+ *
+ * Options must be set before the dispatcher starts running.
+ */
+struct dispatcher_opt
+{
+  /// @name Running Jobs
+
+  std::optional<std::size_t> num_workers{}; ///< threads executing jobs
+  std::optional<std::size_t>
+    batch_size{}; ///< max jobs a worker takes at once from the queue
+  std::optional<std::size_t>
+    control_burst{}; ///< control jobs in a row before a data job gets a turn
+  std::optional<std::size_t>
+    fair_quantum{}; ///< message bytes a pipe takes per round, 0 for FIFO
+
+  /// @name Waiting For Jobs
+  ///
+  /// An idle worker polls the queue idle_spins times busy-spinning, then
+  /// idle_yields times yielding the CPU, before sleeping: producers don't wake
+  /// spinning workers up, trading CPU time for latency. Worth it on dedicated
+  /// cores only, see worker_placement.
+
+  std::optional<std::size_t>
+    idle_spins{}; ///< polls busy-spinning, 0 by default
+  std::optional<std::size_t>
+    idle_yields{}; ///< polls yielding the CPU, 0 by default
+
+  /// @name Running Async Jobs
+
+  std::optional<std::size_t>
+    num_async_workers{}; ///< threads of the pool executing async jobs
+
+  /// @name Thread Placement
+  ///
+  /// Linux only, see thread_placement. The thread calling run is placed as
+  /// the first worker until run returns. The threads of nng can't be placed,
+  /// confine the whole process instead (eg: taskset, cpuset cgroups).
+
+  std::optional<thread_placement>
+    worker_placement{}; ///< threads executing jobs, the one calling run too
+  std::optional<thread_placement>
+    async_worker_placement{}; ///< threads of the pool executing async jobs
+
+  /// @name Backpressure
+  ///
+  /// Crossing an high watermark pauses re-arming receives, which resume once
+  /// queued jobs are below both low watermarks (by default, half the high).
+
+  std::optional<std::size_t>
+    high_watermark_jobs{}; ///< queued jobs that pause receiving
+  std::optional<std::size_t>
+    low_watermark_jobs{}; ///< queued jobs that resume receiving
+  std::optional<std::size_t>
+    high_watermark_bytes{}; ///< queued message bytes that pause receiving
+  std::optional<std::size_t>
+    low_watermark_bytes{}; ///< queued message bytes that resume receiving
+
+  /// @name Decoding
+
+  std::optional<bool>
+    decode_on_receive{}; ///< decode messages on the nng thread, before queueing
+
+  /// @name Load Shedding
+  ///
+  /// Once jobs keep waiting queued longer than shed_target for shed_interval,
+  /// droppable jobs are shed until the wait gets below the target again: the
+  /// handler of fired<overloaded> runs in their place.
+
+  std::optional<std::chrono::microseconds>
+    shed_target{}; ///< acceptable queue wait, 0 never sheds
+  std::optional<std::chrono::microseconds>
+    shed_interval{}; ///< how long above target before shedding
+
+  /// @name Deadlines
+
+  std::optional<bool>
+    edf{}; ///< data jobs earliest deadline first, overrides fair_quantum
+};
+
+} // namespace pars::ev
@@ -35,23 +35,61 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pars/ev/event.h"
 #include "pars/ev/hf_registry.h"
 #include "pars/ev/runner.h"
+#include "pars/ev/shard.h"
+#include "pars/ev/threading.h"
+
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
 
 namespace pars::ev
 {
 
+/**
+ * @brief Routes events to the dispatcher that has to run them
+ *
+ * With many shards, events of a context always go to the same shard, as do
+ * events of a pipe received on a socket. Internal events stay on the shard
+ * that fires them, unless explicitly posted to another one.
+ *
+ * @note internal events fired by a thread that is not a worker or an async
+ * worker of a shard (eg: an nng callback, a timer or a thread of the
+ * application) have no shard to stay on, they go to the first one: use post
+ * to pick another one.
+ */
 class enqueuer
 {
 public:
   enqueuer(dispatcher& d, runner& r)
-    : dispatcher_m{d}
-    , runner_m{r}
+    : dispatchers_m{d}
+    , runners_m{r}
   {
   }
 
+  enqueuer(std::span<const std::unique_ptr<shard>> shards)
+  {
+    for (const auto& s : shards)
+    {
+      dispatchers_m.push_back(s->dispatcher());
+
+      runners_m.push_back(s->runner());
+    }
+  }
+
+  /// queue ev on the shard of the calling thread, the first one if it has
+  /// none, see this_shard
   template<internal_event_c event_t>
   void queue_fire(event_t ev)
   {
-    dispatcher_m.queue_back(fired{std::move(ev), {}});
+    post(current_shard(), std::move(ev));
+  }
+
+  /// queue ev on the given shard, from any thread
+  template<internal_event_c event_t>
+  void post(const std::size_t shard_idx, event_t ev)
+  {
+    dispatchers_m.at(shard_idx).get().queue_back(fired{std::move(ev), {}});
   }
 
   template<template<typename> typename kind_of, network_event_c event_t,
@@ -65,44 +103,157 @@ public:
   template<network_event_c event_t, net::tool_c tool_t>
   void queue_fire(event_t ev, const int s_id, tool_t& t, const net::pipe& p)
   {
+    auto& d = dispatcher_of(t, p);
+
     if constexpr (std::is_same_v<event_t, creating_pipe> ||
                   std::is_same_v<event_t, pipe_created> ||
                   std::is_same_v<event_t, pipe_removed>)
     {
-      if (dispatcher_m.terminating())
+      if (d.terminating())
       {
         p.close().or_abort();
 
         return;
       }
 
+      // jobs of a pipe may run on any shard
       if constexpr (std::is_same_v<event_t, creating_pipe>)
-        runner_m.add_pipe(p);
+      {
+        for (auto& r : runners_m)
+          r.get().add_pipe(p);
+      }
       else if constexpr (std::is_same_v<event_t, pipe_removed>)
-        runner_m.remove_pipe(p);
+      {
+        for (auto& r : runners_m)
+          r.get().remove_pipe(p);
+      }
 
-      if (!runner_m.can_exec(s_id, spec<fired<event_t>>::hash))
+      if (!runner_of(t, p).can_exec(s_id, spec<fired<event_t>>::hash))
         return;
     }
 
-    dispatcher_m.queue_back(fired{std::move(ev), {s_id, t, p}});
+    d.queue_back(fired{std::move(ev), {s_id, t, p}});
   }
 
   template<network_event_c event_t, net::tool_c tool_t>
   void queue_sent(event_t ev, int s_id, tool_t& t, net::pipe p)
   {
-    dispatcher_m.queue_back(sent{std::move(ev), {s_id, t, p}});
+    run_inline_or_queue(t, p, sent{std::move(ev), {s_id, t, p}});
   }
 
   template<net::tool_c tool_t>
   void queue_received(nngxx::msg m, int s_id, tool_t& t, net::pipe p)
   {
-    dispatcher_m.queue_back(received{std::move(m), {s_id, t, p}});
+    run_inline_or_queue(t, p, received{std::move(m), {s_id, t, p}});
+  }
+
+  std::size_t num_shards() const { return dispatchers_m.size(); }
+
+  /// @name Backpressure
+
+  /// defer f, that re-arms a receive on t, while the dispatcher the received
+  /// messages go to is congested; false if f has to be run right away
+  template<net::tool_c tool_t>
+  bool defer_recv(const void* key, tool_t& t, std::move_only_function<void()> f)
+  {
+    // messages received on a context go to its shard, on a socket to any
+    if (is_context(t))
+    {
+      auto& d = dispatchers_m[shard_of(t, {})].get();
+
+      return d.congested() && d.defer_while_congested(key, std::move(f));
+    }
+
+    for (auto& d : dispatchers_m)
+      if (d.get().congested())
+        return d.get().defer_while_congested(key, std::move(f));
+
+    return false;
+  }
+
+  /// drop the deferred receive of key, if any
+  void cancel_recv(const void* key)
+  {
+    for (auto& d : dispatchers_m)
+      d.get().cancel_deferred(key);
   }
 
 private:
-  dispatcher& dispatcher_m;
-  runner& runner_m;
+  /// the shard of the calling thread, the first one otherwise
+  std::size_t current_shard() const
+  {
+    auto idx = this_shard();
+
+    return idx && *idx < dispatchers_m.size() ? *idx : 0;
+  }
+
+  template<net::tool_c tool_t>
+  static bool is_context(tool_t& t)
+  {
+    if constexpr (std::is_same_v<std::remove_const_t<tool_t>, net::context>)
+      return true;
+    else if constexpr (std::is_same_v<std::remove_const_t<tool_t>,
+                                      net::tool_view>)
+      return t.type() == typeid(nngxx::ctx_view);
+    else
+      return false;
+  }
+
+  /// contexts are sharded by id, pipes of a socket by pipe id
+  template<net::tool_c tool_t>
+  std::size_t shard_of(tool_t& t, const net::pipe& p) const
+  {
+    if (dispatchers_m.size() == 1)
+      return 0;
+
+    auto key = is_context(t) ? t.id() : p.id();
+
+    return static_cast<std::size_t>(key) % dispatchers_m.size();
+  }
+
+  /// run ke right away, on the calling nng I/O thread, if its handler
+  /// executes::inline_io; queue it on its shard otherwise
+  template<template<typename> typename kind_of, network_event_c event_t,
+           net::tool_c tool_t>
+    requires kind_c<kind_of>
+  void run_inline_or_queue(tool_t& t, const net::pipe& p, kind_of<event_t> ke)
+  {
+    auto& d = dispatcher_of(t, p);
+
+    // a received message is a spec known only at runtime
+    if constexpr (std::is_same_v<event_t, nngxx::msg> ||
+                  inline_io_event_c<event_t, kind_of>)
+    {
+      auto& r = runner_of(t, p);
+
+      if (!d.terminating() &&
+          r.runs_inline(ke.md().socket_id(), compute_spec_hash(ke)))
+      {
+        r.exec_inline(std::move(ke));
+
+        return;
+      }
+    }
+
+    d.queue_back(std::move(ke));
+  }
+
+  template<net::tool_c tool_t>
+  dispatcher& dispatcher_of(tool_t& t, const net::pipe& p)
+  {
+    return dispatchers_m[shard_of(t, p)];
+  }
+
+  template<net::tool_c tool_t>
+  runner& runner_of(tool_t& t, const net::pipe& p)
+  {
+    return runners_m[shard_of(t, p)];
+  }
+
+  std::vector<std::reference_wrapper<dispatcher>>
+    dispatchers_m; ///< the dispatcher of each shard
+  std::vector<std::reference_wrapper<runner>>
+    runners_m; ///< the runner of each shard
 };
 
 } // namespace pars::ev
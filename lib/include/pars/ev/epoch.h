@@ -0,0 +1,158 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace pars::ev
+{
+
+/**
+ * @brief Epoch based reclamation of what is read without locking
+ *
+ * A reader holds a guard for as long as it uses a pointer read from a shared
+ * structure: the guard pins the current epoch in a record of its thread. A
+ * writer replacing that pointer advances the epoch, and frees what it
+ * replaced once quiescent_since that epoch: no reader is pinned before it
+ * anymore, so none can still hold the old pointer.
+ *
+ * A guard costs two stores and a fence, on a cache line of its own thread;
+ * readers never wait. Records are recycled across threads, never released.
+ */
+class epoch
+{
+  struct record;
+
+public:
+  /// pins the calling thread in the current epoch until destroyed, guards
+  /// can be nested
+  class guard
+  {
+  public:
+    guard()
+      : rec_m{mine()}
+    {
+      if (rec_m.depth++ > 0)
+        return;
+
+      rec_m.pinned.store(current_m.load(), std::memory_order_relaxed);
+
+      // the pointer guarded is read after the pin is visible to writers
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    guard(const guard&) = delete;
+
+    guard& operator=(const guard&) = delete;
+
+    ~guard()
+    {
+      if (--rec_m.depth == 0)
+        rec_m.pinned.store(0, std::memory_order_release);
+    }
+
+  private:
+    record& rec_m;
+  };
+
+  /// start a new epoch, call it after replacing a pointer readers may hold;
+  /// returns the epoch the replaced one can be freed since
+  static std::uint64_t advance() { return current_m.fetch_add(1) + 1; }
+
+  /// whether no reader is pinned in an epoch before e
+  static bool quiescent_since(const std::uint64_t e)
+  {
+    // the pins are read after the pointer was replaced and e started
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (auto* r = records_m.load(std::memory_order_acquire); r; r = r->next)
+    {
+      auto pinned = r->pinned.load(std::memory_order_acquire);
+
+      if (pinned != 0 && pinned < e)
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  /// on a cache line of its own, readers don't share theirs
+  struct alignas(64) record
+  {
+    std::atomic<std::uint64_t> pinned{0}; ///< epoch pinned, 0 if none
+    std::atomic<bool> owned{true};        ///< by a running thread
+    std::size_t depth{0};                 ///< guards nested, owner only
+    record* next{nullptr};                ///< immutable once listed
+  };
+
+  /// the record of the calling thread, given back when the thread exits
+  static record& mine()
+  {
+    struct owner
+    {
+      record* rec = acquire();
+
+      ~owner() { rec->owned.store(false, std::memory_order_release); }
+    };
+
+    thread_local auto o = owner{};
+
+    return *o.rec;
+  }
+
+  /// a record left by an exited thread, or a new one
+  static record* acquire()
+  {
+    for (auto* r = records_m.load(std::memory_order_acquire); r; r = r->next)
+    {
+      auto owned = false;
+
+      if (r->owned.compare_exchange_strong(owned, true))
+        return r;
+    }
+
+    auto* r = new record{};
+
+    r->next = records_m.load(std::memory_order_relaxed);
+
+    while (!records_m.compare_exchange_weak(r->next, r))
+      ;
+
+    return r;
+  }
+
+  static inline std::atomic<std::uint64_t> current_m{1}; ///< 0 is never pinned
+  static inline std::atomic<record*> records_m{nullptr}; ///< push-only list
+};
+
+} // namespace pars::ev
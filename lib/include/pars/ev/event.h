@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "pars/ev/klass.h"
 #include "pars/fmt/stl.h"
+#include "pars/log/nametype.h"
 #include "pars/net/dir.h"
 
 #include "clev/err.h"
@@ -56,6 +57,8 @@ struct klass<creating_pipe> : base_klass<creating_pipe>
 {
   static constexpr std::string_view uuid =
     "adf2e44f-b005-449b-b849-e2b46377c122";
+
+  static constexpr ev::priority priority = ev::priority::control;
 };
 
 struct pipe_created
@@ -71,6 +74,8 @@ struct klass<pipe_created> : base_klass<pipe_created>
 {
   static constexpr std::string_view uuid =
     "2410aea6-ce8e-46d7-b3c4-0ef8ab598ef9";
+
+  static constexpr ev::priority priority = ev::priority::control;
 };
 
 struct pipe_removed
@@ -86,6 +91,8 @@ struct klass<pipe_removed> : base_klass<pipe_removed>
 {
   static constexpr std::string_view uuid =
     "5fe36da8-c46a-4ef4-872d-5f11d610eaeb";
+
+  static constexpr ev::priority priority = ev::priority::control;
 };
 
 struct network_error
@@ -105,6 +112,8 @@ struct klass<network_error> : base_klass<network_error>
 {
   static constexpr std::string_view uuid =
     "53b44f06-c5b3-400f-8e7e-522cb39c1168";
+
+  static constexpr ev::priority priority = ev::priority::control;
 };
 
 struct exception
@@ -145,6 +154,75 @@ struct klass<exception> : base_klass<exception>
     "25d02d6b-38d1-414b-a5ff-60d93c7746c9";
 
   static constexpr bool requires_network = false;
+
+  static constexpr ev::priority priority = ev::priority::control;
+};
+
+/// a droppable job was shed, instead of running its handler, because the
+/// dispatcher is overloaded; the metadata are the ones of the job shed
+struct overloaded
+{
+  std::size_t spec_hash = 0;            ///< the spec of the job shed
+  std::chrono::microseconds sojourn{0}; ///< how long it waited queued
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "overloaded(spec:0x{:X}, {}us)",
+                          spec_hash, sojourn.count());
+  }
+};
+
+template<>
+struct klass<overloaded> : base_klass<overloaded>
+{
+  static constexpr std::string_view uuid =
+    "5f3b9c8e-1d47-4a26-b7e5-0c8a9d2f6e13";
+};
+
+/// a job expired before running its handler, see dispatcher_opt::edf; the
+/// metadata are the ones of the job expired
+struct expired
+{
+  std::size_t spec_hash = 0;         ///< the spec of the job expired
+  std::chrono::microseconds late{0}; ///< how long after its deadline
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "expired(spec:0x{:X}, {}us late)",
+                          spec_hash, late.count());
+  }
+};
+
+template<>
+struct klass<expired> : base_klass<expired>
+{
+  static constexpr std::string_view uuid =
+    "c81e4d3a-6b92-4f07-9a5c-3e7d1b8f0a24";
+};
+
+/// a timer expired, see timer; it carries the tag it was armed with, so that
+/// eg: a per-pipe timer tells which pipe it is about
+template<typename tag_t>
+struct timer_expired
+{
+  tag_t tag;
+  std::chrono::microseconds late{0}; ///< how long after its expiry
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "timer_expired({}, {}us late)",
+                          nametype<tag_t>(), late.count());
+  }
+};
+
+/// a timer tag is any type with a uuid of its own, that tells apart the
+/// timer_expired of different tags
+template<typename tag_t>
+struct klass<timer_expired<tag_t>> : base_klass<timer_expired<tag_t>>
+{
+  static constexpr std::string_view uuid = tag_t::uuid;
+
+  static constexpr bool requires_network = false;
 };
 
 struct init
@@ -187,6 +265,8 @@ struct klass<shutdown> : base_klass<shutdown>
     "47c543bb-ba37-4442-a5bd-4b2dcfbf1e02";
 
   static constexpr bool requires_network = false;
+
+  static constexpr ev::priority priority = ev::priority::control;
 };
 
 } // namespace pars::ev
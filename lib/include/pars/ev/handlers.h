@@ -0,0 +1,141 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/concept/event.h"
+#include "pars/ev/job.h"
+#include "pars/ev/make_hf.h"
+#include "pars/ev/spec.h"
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pars::ev
+{
+
+/// a plain function executing a job on an instance of a class
+using static_hf = void (*)(void* self, job j);
+
+/**
+ * @brief A statically known handler, eg: ev::handler<&component::on_ping>
+ */
+template<auto mem_fn>
+struct handler
+{
+  using traits = hf_traits<decltype(mem_fn)>;
+
+  using class_type = traits::class_type;
+
+  template<typename event2_t>
+  using kind_type = traits::template kind_type<event2_t>;
+
+  using event_type = traits::event_type;
+
+  using kind_of_event_type = kind_type<event_type>;
+
+  static_assert(sync_event_c<event_type, kind_type>,
+                "Async handlers must be inserted with on<>()");
+
+  static constexpr std::size_t spec_hash = spec<kind_of_event_type>::hash;
+
+  static void invoke(void* self, job j)
+  {
+    auto ke = j.event<kind_type, event_type>();
+
+    ke.md().set_job_id(j.id());
+
+    ke.md().set_deadline(j.deadline());
+
+    (static_cast<class_type*>(self)->*mem_fn)(std::move(ke));
+  }
+};
+
+/**
+ * @brief A compile-time list of the handlers of a class
+ *
+ * Every handler gets a dense id, its position in the list. A spec hash is
+ * mapped to its id by a generated chain of comparisons against compile-time
+ * constants, then the handler is reached through a flat array of plain
+ * function pointers: no hashing, no std::function.
+ */
+template<typename... handler_t>
+struct handlers
+{
+  static_assert(sizeof...(handler_t) > 0, "At least one handler is required");
+
+  using class_type = std::tuple_element_t<
+    0, std::tuple<typename handler_t::class_type...>>;
+
+  static_assert(
+    (std::is_same_v<class_type, typename handler_t::class_type> && ...),
+    "Handlers must belong to the same class");
+
+  static constexpr std::size_t size = sizeof...(handler_t);
+
+  static constexpr std::array<std::size_t, size> spec_hashes{
+    handler_t::spec_hash...};
+
+  /// the dense id of spec_hash, size if not handled
+  static constexpr std::size_t id_of(const std::size_t spec_hash)
+  {
+    return id_of(spec_hash, std::index_sequence_for<handler_t...>{});
+  }
+
+  /// the dense id of a kind_of<event_t>, at compile time
+  template<typename kind_of_event_t>
+  static constexpr std::size_t id = id_of(spec<kind_of_event_t>::hash);
+
+  /// the handler of spec_hash, nullptr if not handled
+  static static_hf handler_for(const std::size_t spec_hash)
+  {
+    auto i = id_of(spec_hash);
+
+    return i < size ? table[i] : nullptr;
+  }
+
+private:
+  template<std::size_t... i>
+  static constexpr std::size_t id_of(const std::size_t spec_hash,
+                                     std::index_sequence<i...>)
+  {
+    auto res = size;
+
+    ((spec_hash == handler_t::spec_hash ? (res = i, true) : false) || ...);
+
+    return res;
+  }
+
+  static constexpr std::array<static_hf, size> table{&handler_t::invoke...};
+};
+
+} // namespace pars::ev
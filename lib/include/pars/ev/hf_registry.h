@@ -30,14 +30,27 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "pars/concept/kind.h"
+#include "pars/ev/epoch.h"
+#include "pars/ev/handlers.h"
 #include "pars/ev/job.h"
 #include "pars/ev/make_hf.h"
 #include "pars/ev/spec.h"
+#include "pars/ev/task.h"
 #include "pars/fmt/formattable.h"
 #include "pars/log.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace pars::ev
 {
@@ -59,22 +72,111 @@ namespace pars::ev
 
 using job_handler_f = std::function<void(job)>;
 
+/// decodes the received<nngxx::msg> of a job into a received<event_t>
+using decoder_f = void (*)(job&);
+
+/// the metadata of the network event of a job, without taking it
+using network_md_f = base_network_metadata (*)(job&);
+
+/// what is known at compile time of the kind_of<event_t> of a spec hash
+struct kind_info
+{
+  network_md_f network_md = nullptr; ///< nullptr for internal events
+  bool droppable = false;            ///< see overloaded
+  std::chrono::microseconds deadline{0}; ///< see dispatcher_opt::edf
+};
+
+/**
+ * @brief The handler_f registered for every spec, on every socket
+ *
+ * Lookups are wait-free: they read an immutable snapshot published through an
+ * atomic pointer, pinning the current epoch meanwhile. Every insert, usually
+ * at startup, copies the current snapshot under a lock and publishes the
+ * copy: it costs O(# handlers), time and memory. The snapshot replaced is
+ * freed as soon as no lookup may still read it, see epoch; the handlers are
+ * kept apart until the registry is destroyed, a handler found stays valid
+ * while it runs.
+ */
 struct hf_registry
 {
 public:
   hf_registry(runner& r)
     : runner_m{r}
   {
+    published_m = std::make_unique<const snapshot>();
+
+    current_m = published_m.get();
   }
 
+  hf_registry(const hf_registry&) = delete;
+
+  hf_registry& operator=(const hf_registry&) = delete;
+
   template<template<typename> typename kind_of, ev::event_c event_t,
-           typename class_t>
+           typename class_t, ev::handler_return_c return_t>
     requires ev::kind_c<kind_of>
-  void on(void (class_t::*mem_fn)(hf_arg<kind_of, event_t>), class_t* self)
+  void on(return_t (class_t::*mem_fn)(hf_arg<kind_of, event_t>), class_t* self)
   {
     insert<kind_of, event_t>(make_hf(mem_fn, self));
   }
 
+  /// snapshots not freed yet, the published one included
+  std::size_t num_snapshots() const
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    return 1 + retired_m.size();
+  }
+
+  /// Insert statically known handlers, eg:
+  /// on(ev::handlers<ev::handler<&C::f>, ev::handler<&C::g>>{}, this)
+  ///
+  /// They're looked up before the ones inserted with on<>(), see handlers.
+  template<typename... handler_t>
+  void on(handlers<handler_t...> list,
+          typename handlers<handler_t...>::class_type* self)
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    auto next = std::make_unique<snapshot>(*current_m.load());
+
+    for (auto spec_hash : list.spec_hashes)
+    {
+      if (next->static_for(spec_hash).second ||
+          next->handlers[0].contains(spec_hash))
+        throw std::runtime_error(fmt::format(
+          "Unable to emplace the static handler for Spec {:X}", spec_hash));
+    }
+
+    (next->template add_kind<handler_t::template kind_type,
+                             typename handler_t::event_type>(),
+     ...);
+
+    next->statics.push_back({self, &handlers<handler_t...>::handler_for});
+
+    publish(std::move(next));
+
+    registrations_m.push_back(
+      [list, self](hf_registry& other) { other.on(list, self); });
+
+    pars::debug(SL, lf::event, "Registered {} static handlers!", list.size);
+  }
+
+  /// Insert into other every handler_f inserted so far into this registry
+  ///
+  /// The handler_f are shared, while jobs are run by the runner of other.
+  void clone_into(hf_registry& other)
+  {
+    auto lock = std::unique_lock{mtx_m};
+
+    auto registrations = registrations_m;
+
+    lock.unlock();
+
+    for (auto& r : registrations)
+      r(other);
+  }
+
 private:
   friend net::rep;
   friend net::req;
@@ -92,46 +194,222 @@ private:
     requires kind_c<kind_of>
   void insert(int s_id, handler_f<kind_of, event_t> hf);
 
-  auto lock() { return std::unique_lock{mtx_m}; }
+  /// Insert a shared handler_f for a kind_of<event_t> on a socket s_id
+  template<template<typename> typename kind_of, event_c event_t>
+    requires kind_c<kind_of>
+  void insert(int s_id, std::shared_ptr<handler_f<kind_of, event_t>> hf_ptr);
+
+  /// the handler_f of spec_hash on socket s_id, nullptr if none; wait-free
+  const job_handler_f* handler_for(int s_id, std::size_t spec_hash) const
+  {
+    auto pin = epoch::guard{};
+
+    auto& handlers = current_m.load(std::memory_order_acquire)->handlers;
+
+    auto it = handlers.find(s_id);
+
+    if (it == handlers.end())
+      return nullptr;
+
+    auto it2 = it->second.find(spec_hash);
+
+    return it2 != it->second.end() ? it2->second : nullptr;
+  }
+
+  /// the statically known handler of spec_hash and its instance, if any;
+  /// wait-free
+  std::pair<void*, static_hf> static_handler_for(int s_id,
+                                                 std::size_t spec_hash) const
+  {
+    if (s_id != 0)
+      return {nullptr, nullptr};
+
+    auto pin = epoch::guard{};
+
+    return current_m.load(std::memory_order_acquire)->static_for(spec_hash);
+  }
+
+  bool has_handler_for(int s_id, std::size_t spec_hash) const
+  {
+    return static_handler_for(s_id, spec_hash).second ||
+           handler_for(s_id, spec_hash) != nullptr;
+  }
 
-  bool has_handler_for(int s_id, std::size_t spec_hash)
+  /// whether the handler of spec_hash executes::inline_io; wait-free
+  bool runs_inline(std::size_t spec_hash) const
   {
-    return handlers_m[s_id].contains(spec_hash);
+    auto pin = epoch::guard{};
+
+    return current_m.load(std::memory_order_acquire)
+      ->inline_io.contains(spec_hash);
   }
 
-  const std::type_info* const type_for(std::size_t spec_hash)
+  /// the decoder of the received<event_t> of spec_hash, if any; wait-free
+  decoder_f decoder_for(std::size_t spec_hash) const
   {
-    return types_m[spec_hash];
+    auto pin = epoch::guard{};
+
+    auto& decoders = current_m.load(std::memory_order_acquire)->decoders;
+
+    auto it = decoders.find(spec_hash);
+
+    return it != decoders.end() ? it->second : nullptr;
+  }
+
+  /// what is known of spec_hash, nullopt if never registered; wait-free
+  std::optional<kind_info> info_for(std::size_t spec_hash) const
+  {
+    auto pin = epoch::guard{};
+
+    auto& infos = current_m.load(std::memory_order_acquire)->infos;
+
+    auto it = infos.find(spec_hash);
+
+    return it != infos.end() ? std::optional{it->second} : std::nullopt;
   }
 
-  const job_handler_f& handler_for(int s_id, std::size_t spec_hash)
+  /// the type of spec_hash, for logging purpose; wait-free
+  const std::type_info* type_for(std::size_t spec_hash) const
   {
-    return handlers_m[s_id][spec_hash];
+    auto pin = epoch::guard{};
+
+    auto& types = current_m.load(std::memory_order_acquire)->types;
+
+    auto it = types.find(spec_hash);
+
+    return it != types.end() ? it->second : &typeid(void);
   }
 
+  /// NOTE: called with mtx_m held
   template<template<typename> typename kind_of, event_c event_t>
     requires kind_c<kind_of>
   auto insert_jhf(int s_id, job_handler_f hf)
   {
     auto spec_hash = spec<kind_of<event_t>>::hash;
 
-    if (!handlers_m[s_id].try_emplace(spec_hash, std::move(hf)).second)
+    // copy on write
+    auto next = std::make_unique<snapshot>(*current_m.load());
+
+    auto& stored = hfs_m.emplace_back(std::move(hf));
+
+    if ((s_id == 0 && next->static_for(spec_hash).second) ||
+        !next->handlers[s_id].try_emplace(spec_hash, &stored).second)
+    {
+      hfs_m.pop_back();
+
       throw std::runtime_error(fmt::format(
         "Unable to emplace the handler_f for Socket #{} and Spec {:X}", s_id,
         spec_hash));
+    }
+
+    next->add_kind<kind_of, event_t>();
 
-    // register the type for logging purpose
-    types_m[spec_hash] = &typeid(kind_of<event_t>);
+    publish(std::move(next));
 
     pars::debug(SL, lf::event, "Socket {}: Registered {}!", s_id,
                 spec<kind_of<event_t>>{});
   }
 
-  std::mutex mtx_m; /// protects handlers_m, types_m
-  std::unordered_map<int, std::unordered_map<std::size_t, job_handler_f>>
-    handlers_m; ///< job_handler_f of a spec hash
-  std::unordered_map<std::size_t, const std::type_info*>
-    types_m; ///< type_info of a spec hash, for debugging purpose only
+  /// a handlers list inserted with on, and its instance
+  struct static_table
+  {
+    void* self;
+    static_hf (*handler_for)(std::size_t spec_hash);
+  };
+
+  /// the handlers registered at a given time, never modified once published
+  struct snapshot
+  {
+    std::unordered_map<int,
+                       std::unordered_map<std::size_t, const job_handler_f*>>
+      handlers; ///< job_handler_f of a spec hash, see hfs_m
+    std::unordered_map<std::size_t, const std::type_info*>
+      types; ///< type_info of a spec hash, for debugging purpose only
+    std::vector<static_table> statics; ///< statically known handlers
+    std::unordered_set<std::size_t>
+      inline_io; ///< spec hashes run on the nng I/O thread
+    std::unordered_map<std::size_t, decoder_f>
+      decoders; ///< decoder of a received<event_t> spec hash
+    std::unordered_map<std::size_t, kind_info>
+      infos; ///< kind_info of a spec hash
+
+    /// register what is known at compile time of a kind_of<event_t>
+    template<template<typename> typename kind_of, event_c event_t>
+    void add_kind()
+    {
+      auto spec_hash = spec<kind_of<event_t>>::hash;
+
+      // register the type for logging purpose
+      types[spec_hash] = &typeid(kind_of<event_t>);
+
+      // only sent and received events complete on an nng I/O thread
+      if constexpr (!is_same_kind_v<kind_of, fired> &&
+                    inline_io_event_c<event_t, kind_of>)
+        inline_io.insert(spec_hash);
+
+      if constexpr (is_same_kind_v<kind_of, received> &&
+                    !std::is_same_v<event_t, nngxx::msg>)
+        decoders[spec_hash] = [](job& j) { j.decode<event_t>(); };
+
+      auto& info = infos[spec_hash];
+
+      // shedding and expiring fire an event with the same metadata
+      if constexpr (network_event_c<event_t>)
+        info.network_md = [](job& j) {
+          return j.network_md<kind_of, event_t>();
+        };
+
+      // overloaded and expired replace a job on its pipe, internal ones have
+      // none: they'd be dropped silently
+      static_assert(!klass_traits<event_t>::replaceable ||
+                      network_event_c<event_t>,
+                    "Only network events can be droppable or have a deadline!");
+
+      info.droppable = klass_traits<event_t>::droppable;
+
+      info.deadline = klass_traits<event_t>::deadline;
+    }
+
+    std::pair<void*, static_hf> static_for(std::size_t spec_hash) const
+    {
+      for (const auto& t : statics)
+        if (auto fn = t.handler_for(spec_hash))
+          return {t.self, fn};
+
+      return {nullptr, nullptr};
+    }
+  };
+
+  /// a snapshot replaced, and the epoch it can be freed since
+  struct retired
+  {
+    std::unique_ptr<const snapshot> snap;
+    std::uint64_t since;
+  };
+
+  /// NOTE: called with mtx_m held
+  void publish(std::unique_ptr<snapshot> next)
+  {
+    current_m.store(next.get());
+
+    retired_m.push_back({std::move(published_m), epoch::advance()});
+
+    published_m = std::move(next);
+
+    // what lookups still read is freed by a later publish, or on destruction
+    std::erase_if(retired_m, [](const retired& r) {
+      return epoch::quiescent_since(r.since);
+    });
+  }
+
+  mutable std::mutex mtx_m; ///< serializes inserts
+  std::atomic<const snapshot*> current_m; ///< the published snapshot
+  std::unique_ptr<const snapshot> published_m; ///< owns current_m
+  std::vector<retired> retired_m; ///< snapshots lookups may still read
+  std::deque<job_handler_f>
+    hfs_m; ///< every handler_f inserted, stable while snapshots are replaced
+  std::vector<std::function<void(hf_registry&)>>
+    registrations_m; ///< replay every insert into another registry
 
   runner& runner_m;
 };
@@ -39,39 +39,55 @@ template<template<typename> typename kind_of, event_c event_t>
   requires kind_c<kind_of>
 void hf_registry::insert(int s_id, handler_f<kind_of, event_t> hf)
 {
-  auto hf_ptr = std::make_shared<handler_f<kind_of, event_t>>(std::move(hf));
+  insert<kind_of, event_t>(
+    s_id, std::make_shared<handler_f<kind_of, event_t>>(std::move(hf)));
+}
 
+template<template<typename> typename kind_of, event_c event_t>
+  requires kind_c<kind_of>
+void hf_registry::insert(int s_id,
+                         std::shared_ptr<handler_f<kind_of, event_t>> hf_ptr)
+{
   auto guard = std::lock_guard{mtx_m};
 
   if constexpr (async_kind_c<kind_of<event_t>>)
   {
-    return insert_jhf<kind_of, event_t>(s_id, [&, hf_ptr](job j) {
-      auto task = std::packaged_task([hf_ptr](std::stop_token tk, job j) {
+    insert_jhf<kind_of, event_t>(s_id, [&, hf_ptr](job j) {
+      auto task = runner::async_task_f([hf_ptr](std::stop_token tk, job j) {
         auto ke = j.event<kind_of, event_t>();
 
         auto& md = ke.md();
 
         md.set_job_id(j.id());
 
+        md.set_deadline(j.deadline());
+
         md.set_stop_token(tk);
 
         (*hf_ptr)(std::move(ke));
       });
 
       runner_m.start_thread(spec<kind_of<event_t>>::hash, std::move(task),
-                            std::move(j));
+                            std::move(j), klass_traits<event_t>::max_in_flight);
     });
   }
   else
   {
-    return insert_jhf<kind_of, event_t>(s_id, [hf_ptr](job j) {
+    insert_jhf<kind_of, event_t>(s_id, [hf_ptr](job j) {
       auto ke = j.event<kind_of, event_t>();
 
       ke.md().set_job_id(j.id());
 
+      ke.md().set_deadline(j.deadline());
+
       (*hf_ptr)(ke);
     });
   }
+
+  // NOTE: only once inserted, a failed insert is not replayed
+  registrations_m.push_back([s_id, hf_ptr](hf_registry& other) {
+    other.insert<kind_of, event_t>(s_id, hf_ptr);
+  });
 }
 
 } // namespace pars::ev
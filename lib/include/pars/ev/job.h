@@ -33,10 +33,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "pars/ev/kind.h"
 #include "pars/ev/metadata.h"
+#include "pars/ev/payload.h"
 #include "pars/ev/serializer.h"
+#include "pars/ev/slot_map.h"
 #include "pars/ev/spec.h"
+#include "pars/ev/task.h"
 
-#include <any>
+#include <chrono>
+#include <optional>
 #include <type_traits>
 
 namespace pars::ev
@@ -45,10 +49,14 @@ namespace pars::ev
 class job
 {
 public:
-  job(std::size_t j_id, int s_id, std::size_t h, std::any ke)
+  job(std::size_t j_id, int s_id, int p_id, std::size_t h, ev::priority prio,
+      std::size_t bytes, payload ke)
     : id_m{j_id}
     , socket_id_m{s_id}
+    , pipe_id_m{p_id}
     , spec_hash_m{h}
+    , priority_m{prio}
+    , bytes_m{bytes}
     , event_kind_m{std::move(ke)}
   {
   }
@@ -66,7 +74,7 @@ public:
              std::is_same_v<event_t, nngxx::msg>)
   kind_of<event_t> event()
   {
-    return std::any_cast<kind_of<event_t>>(std::move(event_kind_m));
+    return event_kind_m.take<kind_of<event_t>>();
   }
 
   template<template<typename> typename kind_of, event_c event_t>
@@ -74,23 +82,102 @@ public:
              !std::is_same_v<event_t, nngxx::msg>)
   received<event_t> event()
   {
-    // get the received<nngxx::msg>
-    auto r = event<received, nngxx::msg>();
+    // the received<nngxx::msg> may have been decoded already
+    if (!event_kind_m.holds<received<event_t>>())
+      decode<event_t>();
 
-    auto& md = r.md();
+    return event_kind_m.take<received<event_t>>();
+  }
+
+  /// replace the received<nngxx::msg> with the received<event_t> it carries
+  ///
+  /// @throws std::bad_any_cast if not a received<nngxx::msg>, or whatever
+  /// deserializing throws; either way the job is left untouched
+  template<network_event_c event_t>
+  void decode()
+  {
+    auto* r = event_kind_m.peek<received<nngxx::msg>>();
+
+    if (!r)
+      throw std::bad_any_cast{};
+
+    auto& md = r->md();
 
-    // return a received<event_t>
-    return received{
-      serialize::to_event<event_t>(r.event()),
-      metadata<received, event_t>{md.socket_id(), md.tool(), md.pipe()}};
+    auto ke =
+      received{serialize::to_event<event_t>(r->event()),
+               metadata<received, event_t>{md.socket_id(), md.tool(),
+                                           md.pipe()}};
+
+    event_kind_m = payload{std::in_place_type<received<event_t>>,
+                           std::move(ke)};
+  }
+
+  /// the metadata of the network event held, without taking it
+  template<template<typename> typename kind_of, network_event_c event_t>
+  base_network_metadata network_md()
+  {
+    // the received<nngxx::msg> may not have been decoded yet
+    if constexpr (is_same_kind_v<kind_of, received> &&
+                  !std::is_same_v<event_t, nngxx::msg>)
+    {
+      if (auto* r = event_kind_m.peek<received<nngxx::msg>>())
+        return r->md();
+    }
+
+    if (auto* ke = event_kind_m.peek<kind_of<event_t>>())
+      return ke->md();
+
+    throw std::bad_any_cast{};
   }
 
   std::size_t id() const { return id_m; }
 
   int socket_id() const { return socket_id_m; }
 
+  /// the id of the pipe this job belongs to, 0 for internal events
+  int pipe_id() const { return pipe_id_m; }
+
+  /// the key of the pipe in the runner, null if not associated
+  slot_key pipe_key() const { return pipe_key_m.key; }
+
+  /// whether the pipe is not removed yet, without locking the runner; false
+  /// if the job was never associated to it
+  bool pipe_alive() const { return pipe_key_m.alive(); }
+
+  void set_pipe_key(watched_key key) { pipe_key_m = key; }
+
   std::size_t spec_hash() const { return spec_hash_m; }
 
+  /// the dispatcher lane of this job
+  ev::priority priority() const { return priority_m; }
+
+  /// the size of the received message, 0 for any other kind of job
+  std::size_t bytes() const { return bytes_m; }
+
+  /// when the job was queued, by the dispatcher
+  std::chrono::steady_clock::time_point queued_at() const
+  {
+    return queued_at_m;
+  }
+
+  void set_queued_at(std::chrono::steady_clock::time_point t)
+  {
+    queued_at_m = t;
+  }
+
+  /// when the job expires, time_point::max() if never
+  std::chrono::steady_clock::time_point deadline() const { return deadline_m; }
+
+  void set_deadline(std::chrono::steady_clock::time_point d) { deadline_m = d; }
+
+  /// the conflation key of its event, if conflated
+  std::optional<std::size_t> conflation_key() const
+  {
+    return conflation_key_m;
+  }
+
+  void set_conflation_key(std::size_t key) { conflation_key_m = key; }
+
   auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
   {
     return fmt::format_to(ctx.out(), "spec:0x{:X}", spec_hash());
@@ -101,8 +188,16 @@ public:
 private:
   std::size_t id_m;
   int socket_id_m;
+  int pipe_id_m;
+  watched_key pipe_key_m;
   std::size_t spec_hash_m;
-  std::any event_kind_m;
+  ev::priority priority_m;
+  std::size_t bytes_m;
+  std::chrono::steady_clock::time_point queued_at_m;
+  std::chrono::steady_clock::time_point deadline_m{
+    std::chrono::steady_clock::time_point::max()};
+  std::optional<std::size_t> conflation_key_m;
+  payload event_kind_m; ///< the kind_of<event_t>, inline if small enough
 };
 
 template<template<typename> typename kind_of, event_c event_t>
@@ -121,8 +216,25 @@ static job make_job(std::size_t j_id, kind_of<event_t> ke)
 {
   auto h = compute_spec_hash(ke);
 
-  return job(j_id, ke.md().socket_id(), h,
-             std::make_any<kind_of<event_t>>(std::move(ke)));
+  auto p_id = 0;
+
+  if constexpr (network_event_c<event_t>)
+    p_id = ke.md().pipe().id();
+
+  // a coroutine handler resumes on the strand of the pipe it suspended on
+  if constexpr (std::is_same_v<event_t, resumed>)
+    p_id = ke.event().pipe_id;
+
+  auto bytes = std::size_t{0};
+
+  if constexpr (std::is_same_v<kind_of<event_t>, received<nngxx::msg>>)
+    bytes = ke.event().body().size();
+
+  auto s_id = ke.md().socket_id();
+  auto pl = payload{std::in_place_type<kind_of<event_t>>, std::move(ke)};
+
+  return job(j_id, s_id, p_id, h, klass_traits<event_t>::priority,
+             bytes, std::move(pl));
 }
 
 } // namespace pars::ev
@@ -34,6 +34,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pars/concept/kind.h"
 #include "pars/net/hash.h"
 
+#include <chrono>
+#include <cstddef>
 #include <string_view>
 
 namespace pars::ev
@@ -55,6 +57,29 @@ struct base_klass
   /// by default, an event_t requires network
   static constexpr bool requires_network = true;
 
+  /// by default, an event_t is queued in the data lane
+  static constexpr ev::priority priority = ev::priority::data;
+
+  /// by default, an event_t is never shed under load, see overloaded; only
+  /// network events can be droppable
+  static constexpr bool droppable = false;
+
+  /// by default, an event_t has no deadline; otherwise the time it may wait
+  /// queued before being expired, see dispatcher_opt::edf; only network
+  /// events can have a deadline
+  static constexpr std::chrono::microseconds deadline{0};
+
+  /// by default, async jobs of an event_t are not limited; otherwise at most
+  /// max_in_flight run at once, the others wait parked in the runner
+  static constexpr std::size_t max_in_flight = 0;
+
+  /// by default, every event_t queued is executed; otherwise a newer event_t
+  /// replaces the one still queued with the same pipe and conflation_key
+  static constexpr bool conflated = false;
+
+  /// the events of a conflated event_t that replace each other
+  static constexpr std::size_t conflation_key(const event_t&) { return 0; }
+
   /// an event_t executes synchronously in every possibile kind_of<event_t>
   template<template<typename> typename kind_of>
     requires kind_c<kind_of>
@@ -70,6 +95,71 @@ struct klass
   using event_type = event_t;
 };
 
+/**
+ * @brief The scheduling traits of klass<event_t>
+ *
+ * A klass<event_t> is not required to derive from base_klass: the traits it
+ * doesn't declare are defaulted as in base_klass.
+ */
+template<typename event_t>
+struct klass_traits
+{
+  using event_type = event_t;
+
+  /// see base_klass::priority
+  static constexpr ev::priority priority = []() {
+    if constexpr (requires { klass<event_t>::priority; })
+      return ev::priority{klass<event_t>::priority};
+    else
+      return base_klass<event_t>::priority;
+  }();
+
+  /// see base_klass::droppable
+  static constexpr bool droppable = []() {
+    if constexpr (requires { klass<event_t>::droppable; })
+      return bool{klass<event_t>::droppable};
+    else
+      return base_klass<event_t>::droppable;
+  }();
+
+  /// see base_klass::deadline
+  static constexpr std::chrono::microseconds deadline = []() {
+    if constexpr (requires { klass<event_t>::deadline; })
+      return std::chrono::microseconds{klass<event_t>::deadline};
+    else
+      return base_klass<event_t>::deadline;
+  }();
+
+  /// see base_klass::max_in_flight
+  static constexpr std::size_t max_in_flight = []() {
+    if constexpr (requires { klass<event_t>::max_in_flight; })
+      return std::size_t{klass<event_t>::max_in_flight};
+    else
+      return base_klass<event_t>::max_in_flight;
+  }();
+
+  /// see base_klass::conflated
+  static constexpr bool conflated = []() {
+    if constexpr (requires { klass<event_t>::conflated; })
+      return bool{klass<event_t>::conflated};
+    else
+      return base_klass<event_t>::conflated;
+  }();
+
+  /// see base_klass::conflation_key
+  static std::size_t conflation_key(const event_t& ev)
+  {
+    if constexpr (requires { klass<event_t>::conflation_key(ev); })
+      return klass<event_t>::conflation_key(ev);
+    else
+      return base_klass<event_t>::conflation_key(ev);
+  }
+
+  /// whether overloaded or expired may run in place of the event, they're
+  /// fired on its pipe: hf_registry rejects internal events that may
+  static constexpr bool replaceable = droppable || deadline.count() > 0;
+};
+
 template<>
 struct klass<nngxx::msg> : base_klass<nngxx::msg>
 {
@@ -88,6 +178,24 @@ struct klass<std::shared_ptr<event_t>> : base_klass<event_t>
 
   static constexpr std::string_view uuid = klass<inner_event_type>::uuid;
 
+  static constexpr ev::priority priority =
+    klass_traits<inner_event_type>::priority;
+
+  static constexpr bool droppable = klass_traits<inner_event_type>::droppable;
+
+  static constexpr std::chrono::microseconds deadline =
+    klass_traits<inner_event_type>::deadline;
+
+  static constexpr std::size_t max_in_flight =
+    klass_traits<inner_event_type>::max_in_flight;
+
+  static constexpr bool conflated = klass_traits<inner_event_type>::conflated;
+
+  static std::size_t conflation_key(const event_type& ev)
+  {
+    return klass_traits<inner_event_type>::conflation_key(*ev);
+  }
+
   template<template<typename> typename kind_of>
     requires kind_c<kind_of>
   static constexpr executes exec_policy()
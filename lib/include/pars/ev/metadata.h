@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pars/net/pipe.h"
 #include "pars/net/tool_view.h"
 
+#include <chrono>
 #include <stop_token>
 
 namespace pars::ev
@@ -52,8 +53,19 @@ struct common_metadata
 
   void set_job_id(int j_id) { job_id_m = j_id; }
 
+  /// when the job expires, time_point::max() if never; pass it on to the
+  /// jobs done on its behalf
+  std::chrono::steady_clock::time_point deadline() const
+  {
+    return deadline_m;
+  }
+
+  void set_deadline(std::chrono::steady_clock::time_point d) { deadline_m = d; }
+
 private:
   int job_id_m;
+  std::chrono::steady_clock::time_point deadline_m{
+    std::chrono::steady_clock::time_point::max()};
 };
 
 struct base_internal_metadata
@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/ev/object_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+namespace pars::ev
+{
+
+/**
+ * @brief A lock-free multi-producer single-consumer FIFO queue
+ *
+ * Any thread may push, only one thread at a time may pop. Producers never
+ * wait on each other: a push is one atomic exchange plus one store.
+ *
+ * A push becomes visible to the consumer only once completed, so try_pop may
+ * report an empty queue while a push is still in progress.
+ *
+ * Nodes are recycled through an object_pool: once warmed up, a push does
+ * not allocate.
+ */
+template<typename value_t>
+class mpsc_queue
+{
+public:
+  using value_type = value_t;
+
+  mpsc_queue()
+    : head_m{nodes_m.make()}
+    , tail_m{head_m.load(std::memory_order_relaxed)}
+  {
+  }
+
+  mpsc_queue(const mpsc_queue&) = delete;
+
+  mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+  ~mpsc_queue()
+  {
+    clear();
+
+    nodes_m.destroy(tail_m);
+  }
+
+  /// push v at the back, from any thread
+  void push(value_type v)
+  {
+    auto n = nodes_m.make();
+
+    n->value.emplace(std::move(v));
+
+    size_m.fetch_add(1, std::memory_order_relaxed);
+
+    auto prev = head_m.exchange(n, std::memory_order_acq_rel);
+
+    prev->next.store(n, std::memory_order_release);
+  }
+
+  /// pop from the front, from the consumer thread only
+  std::optional<value_type> try_pop()
+  {
+    auto next = tail_m->next.load(std::memory_order_acquire);
+
+    if (!next)
+      return std::nullopt;
+
+    auto v = std::optional<value_type>{std::move(*next->value)};
+
+    next->value.reset();
+
+    nodes_m.destroy(tail_m);
+
+    tail_m = next;
+
+    size_m.fetch_sub(1, std::memory_order_relaxed);
+
+    return v;
+  }
+
+  /// drop every value, from the consumer thread only
+  void clear()
+  {
+    while (try_pop())
+      ;
+  }
+
+  /// whether there's nothing to pop, from the consumer thread only
+  bool empty() const
+  {
+    return tail_m->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+  /// approximate number of values, from any thread
+  std::size_t size() const { return size_m.load(std::memory_order_relaxed); }
+
+  /// recycling of the nodes, from any thread
+  pool_stats node_stats() const { return nodes_m.stats(); }
+
+private:
+  struct node
+  {
+    std::atomic<node*> next{nullptr};
+    std::optional<value_type> value;
+  };
+
+  object_pool<node> nodes_m; ///< declared first, destroyed last
+
+  std::atomic<node*> head_m; ///< last pushed node, producers side
+  node* tail_m;              ///< already popped node, consumer side
+  std::atomic<std::size_t> size_m{0};
+};
+
+} // namespace pars::ev
@@ -0,0 +1,239 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace pars::ev
+{
+
+/// how well an object_pool fits the steady state of its owner
+struct pool_stats
+{
+  std::size_t hits = 0;     ///< objects made in a recycled slot
+  std::size_t misses = 0;   ///< objects that needed a new slot
+  std::size_t in_use = 0;   ///< objects made and not yet destroyed
+  std::size_t capacity = 0; ///< slots allocated so far, never released
+
+  pool_stats& operator+=(const pool_stats& o)
+  {
+    hits += o.hits;
+    misses += o.misses;
+    in_use += o.in_use;
+    capacity += o.capacity;
+
+    return *this;
+  }
+};
+
+/**
+ * @brief A thread-safe slab of recycled value_t slots
+ *
+ * Slots are allocated in chunks, doubling in size, and never released until
+ * the pool is destroyed: a destroyed object leaves its slot in a lock-free
+ * free list, the next make reuses it without allocating. Only a make finding
+ * the free list empty takes a lock, to carve a new slot.
+ *
+ * Any thread may make and destroy. Every object must be destroyed before the
+ * pool is.
+ */
+template<typename value_t, std::size_t first_chunk = 64>
+  requires(std::has_single_bit(first_chunk))
+class object_pool
+{
+public:
+  using value_type = value_t;
+
+  object_pool() = default;
+
+  object_pool(const object_pool&) = delete;
+
+  object_pool& operator=(const object_pool&) = delete;
+
+  ~object_pool()
+  {
+    for (auto& c : chunks_m)
+      delete[] c.load(std::memory_order_relaxed);
+  }
+
+  /// construct a value_t in a recycled slot, or in a new one
+  template<typename... args_t>
+  value_type* make(args_t&&... args)
+  {
+    auto* s = acquire();
+
+    try
+    {
+      return ::new (s->storage) value_type(std::forward<args_t>(args)...);
+    }
+    catch (...)
+    {
+      release(s);
+
+      throw;
+    }
+  }
+
+  /// destroy v, made by this pool, and recycle its slot
+  void destroy(value_type* v) noexcept
+  {
+    v->~value_type();
+
+    release(reinterpret_cast<slot*>(v));
+  }
+
+  pool_stats stats() const
+  {
+    return {.hits = hits_m.load(std::memory_order_relaxed),
+            .misses = misses_m.load(std::memory_order_relaxed),
+            .in_use = in_use_m.load(std::memory_order_relaxed),
+            .capacity = carved_m.load(std::memory_order_relaxed)};
+  }
+
+private:
+  struct slot
+  {
+    alignas(value_type) std::byte storage[sizeof(value_type)];
+    std::atomic<std::uint32_t> next{0}; ///< 1 + index of the next free slot
+    std::uint32_t index{0};
+  };
+
+  static constexpr std::size_t max_chunks = 24;
+
+  /// the free list head: a tag, bumped at each change to avoid ABA, and
+  /// 1 + index of the first free slot, 0 if none
+  static constexpr std::uint64_t pack(std::uint64_t tag, std::uint32_t next)
+  {
+    return (tag << 32) | next;
+  }
+
+  static constexpr std::uint64_t tag_of(std::uint64_t head)
+  {
+    return head >> 32;
+  }
+
+  /// slot at index i lives in chunk k, of first_chunk << k slots
+  slot* slot_at(std::uint32_t i) const
+  {
+    auto k = std::bit_width(i / first_chunk + 1) - 1;
+    auto offset = i - first_chunk * ((std::size_t{1} << k) - 1);
+
+    return chunks_m[k].load(std::memory_order_acquire) + offset;
+  }
+
+  slot* acquire()
+  {
+    in_use_m.fetch_add(1, std::memory_order_relaxed);
+
+    auto head = free_m.load(std::memory_order_acquire);
+
+    while (static_cast<std::uint32_t>(head) != 0)
+    {
+      // a slot is never released, reading next of a reused one is harmless
+      auto* s = slot_at(static_cast<std::uint32_t>(head) - 1);
+      auto next = s->next.load(std::memory_order_relaxed);
+
+      if (free_m.compare_exchange_weak(head, pack(tag_of(head) + 1, next),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire))
+      {
+        hits_m.fetch_add(1, std::memory_order_relaxed);
+
+        return s;
+      }
+    }
+
+    misses_m.fetch_add(1, std::memory_order_relaxed);
+
+    return carve();
+  }
+
+  slot* carve()
+  {
+    auto guard = std::lock_guard{carve_mtx_m};
+
+    auto i = carved_m.load(std::memory_order_relaxed);
+    auto k = std::bit_width(i / first_chunk + 1) - 1;
+
+    if (k >= max_chunks)
+    {
+      in_use_m.fetch_sub(1, std::memory_order_relaxed);
+
+      throw std::bad_alloc{};
+    }
+
+    if (!chunks_m[k].load(std::memory_order_relaxed))
+      chunks_m[k].store(new slot[first_chunk << k], std::memory_order_release);
+
+    auto* s = slot_at(static_cast<std::uint32_t>(i));
+
+    s->index = static_cast<std::uint32_t>(i);
+
+    carved_m.store(i + 1, std::memory_order_relaxed);
+
+    return s;
+  }
+
+  void release(slot* s) noexcept
+  {
+    auto head = free_m.load(std::memory_order_relaxed);
+    auto next = std::uint64_t{};
+
+    do
+    {
+      s->next.store(static_cast<std::uint32_t>(head),
+                    std::memory_order_relaxed);
+
+      next = pack(tag_of(head) + 1, s->index + 1);
+    } while (!free_m.compare_exchange_weak(head, next,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+
+    in_use_m.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  std::atomic<std::uint64_t> free_m{0}; ///< head of the free list
+  std::array<std::atomic<slot*>, max_chunks> chunks_m{};
+  std::atomic<std::size_t> carved_m{0}; ///< slots handed out at least once
+  std::mutex carve_mtx_m;               ///< one carve at a time
+
+  std::atomic<std::size_t> hits_m{0};
+  std::atomic<std::size_t> misses_m{0};
+  std::atomic<std::size_t> in_use_m{0};
+};
+
+} // namespace pars::ev
@@ -0,0 +1,190 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <any>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/// bytes of a kind_of<event_t> stored inline in a job, larger ones go to heap
+#ifndef PARS_JOB_PAYLOAD_CAPACITY
+#define PARS_JOB_PAYLOAD_CAPACITY 96
+#endif
+
+namespace pars::ev
+{
+
+/**
+ * @brief A type-erased value with inline storage
+ *
+ * Like a move-only std::any, but values up to capacity bytes are stored in
+ * place: the kinds of the built-in events and of most application events
+ * never allocate. Larger values, or ones that may throw while moving, are
+ * stored on the heap.
+ */
+class payload
+{
+public:
+  static constexpr std::size_t capacity = PARS_JOB_PAYLOAD_CAPACITY;
+
+  /// whether a value_t is stored inline
+  template<typename value_t>
+  static constexpr bool fits_inline =
+    sizeof(value_t) <= capacity &&
+    alignof(value_t) <= alignof(std::max_align_t) &&
+    std::is_nothrow_move_constructible_v<value_t>;
+
+  payload() = default;
+
+  template<typename value_t, typename... args_t>
+  explicit payload(std::in_place_type_t<value_t>, args_t&&... args)
+    : ops_m{&ops_for<value_t>}
+  {
+    if constexpr (fits_inline<value_t>)
+      ::new (buf_m) value_t(std::forward<args_t>(args)...);
+    else
+      ::new (buf_m) value_t*(new value_t(std::forward<args_t>(args)...));
+  }
+
+  payload(const payload&) = delete;
+
+  payload(payload&& o) noexcept { move_from(o); }
+
+  payload& operator=(const payload&) = delete;
+
+  payload& operator=(payload&& o) noexcept
+  {
+    if (this != &o)
+    {
+      reset();
+
+      move_from(o);
+    }
+
+    return *this;
+  }
+
+  ~payload() { reset(); }
+
+  bool has_value() const { return ops_m != nullptr; }
+
+  template<typename value_t>
+  bool holds() const
+  {
+    return ops_m == &ops_for<value_t>;
+  }
+
+  /// the value if it is a value_t, nullptr otherwise
+  template<typename value_t>
+  value_t* peek()
+  {
+    return holds<value_t>() ? get<value_t>() : nullptr;
+  }
+
+  /// move the value out, leaving the payload empty
+  ///
+  /// @throws std::bad_any_cast if the value is not a value_t
+  template<typename value_t>
+  value_t take()
+  {
+    if (!holds<value_t>())
+      throw std::bad_any_cast{};
+
+    value_t v(std::move(*get<value_t>()));
+
+    reset();
+
+    return v;
+  }
+
+  void reset()
+  {
+    if (ops_m)
+      ops_m->destroy(buf_m);
+
+    ops_m = nullptr;
+  }
+
+private:
+  struct ops
+  {
+    void (*move)(std::byte* dst, std::byte* src) noexcept;
+    void (*destroy)(std::byte* buf) noexcept;
+  };
+
+  template<typename value_t>
+  static constexpr ops ops_for{
+    .move =
+      [](std::byte* dst, std::byte* src) noexcept {
+        if constexpr (fits_inline<value_t>)
+        {
+          auto* v = std::launder(reinterpret_cast<value_t*>(src));
+
+          ::new (dst) value_t(std::move(*v));
+
+          v->~value_t();
+        }
+        else
+          ::new (dst) value_t*(*std::launder(reinterpret_cast<value_t**>(src)));
+      },
+    .destroy =
+      [](std::byte* buf) noexcept {
+        if constexpr (fits_inline<value_t>)
+          std::launder(reinterpret_cast<value_t*>(buf))->~value_t();
+        else
+          delete *std::launder(reinterpret_cast<value_t**>(buf));
+      }};
+
+  template<typename value_t>
+  value_t* get()
+  {
+    if constexpr (fits_inline<value_t>)
+      return std::launder(reinterpret_cast<value_t*>(buf_m));
+    else
+      return *std::launder(reinterpret_cast<value_t**>(buf_m));
+  }
+
+  void move_from(payload& o) noexcept
+  {
+    if (!o.ops_m)
+      return;
+
+    o.ops_m->move(buf_m, o.buf_m);
+
+    ops_m = std::exchange(o.ops_m, nullptr);
+  }
+
+  const ops* ops_m{nullptr};
+  alignas(std::max_align_t) std::byte buf_m[capacity];
+};
+
+} // namespace pars::ev
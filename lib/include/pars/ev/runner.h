@@ -32,11 +32,23 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pars/ev/event.h"
 #include "pars/ev/hf_registry.h"
 #include "pars/ev/job.h"
-
+#include "pars/ev/mpsc_queue.h"
+#include "pars/ev/object_pool.h"
+#include "pars/ev/slot_map.h"
+#include "pars/ev/task.h"
+#include "pars/ev/worker_pool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
-#include <future>
+#include <mutex>
+#include <optional>
+#include <stop_token>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace pars::ev
 {
@@ -44,6 +56,8 @@ namespace pars::ev
 struct runner
 {
 public:
+  using async_task_f = std::move_only_function<void(std::stop_token, job)>;
+
   runner(hf_registry& hfs)
     : hf_registry_m{hfs}
   {
@@ -51,62 +65,260 @@ public:
 
   std::size_t next_job_id() { return next_job_id_m++; }
 
-  void start_thread(std::size_t spec_hash,
-                    std::packaged_task<void(std::stop_token, job)> task, job j)
+  /// threads executing async jobs, must be set before the first one starts
+  void set_num_async_workers(const std::size_t num_workers)
   {
-    auto j_id = j.id();
+    if (pool_m.started())
+      throw std::runtime_error("Async workers already started!");
 
-    auto s_id = j.socket_id();
+    if (num_workers == 0)
+      throw std::invalid_argument("At least one async worker is required!");
+
+    num_async_workers_m = num_workers;
+  }
+
+  std::size_t num_async_workers() const { return num_async_workers_m; }
+
+  /// where threads executing async jobs run, must be set before the first
+  /// one starts
+  void set_async_placement(thread_placement p)
+  {
+    if (pool_m.started())
+      throw std::runtime_error("Async workers already started!");
+
+    p.validate();
+
+    async_placement_m = std::move(p);
+  }
+
+  const thread_placement& async_placement() const { return async_placement_m; }
+
+  /// the shard whose async jobs run here, see this_shard; must be set before
+  /// the first one starts
+  void set_shard(const std::size_t shard_idx)
+  {
+    if (pool_m.started())
+      throw std::runtime_error("Async workers already started!");
+
+    shard_m = shard_idx;
+  }
+
+  /// called by the pool thread once an async job leaves its completion
+  /// record, eg: to wake a dispatcher worker reaping it; must be set before
+  /// the first async job starts
+  void set_on_completion(std::function<void()> f)
+  {
+    if (pool_m.started())
+      throw std::runtime_error("Async workers already started!");
+
+    on_completion_m = std::move(f);
+  }
+
+  /// whether completion records are waiting to be reaped, from any thread
+  bool has_completions() const { return completions_m.size() > 0; }
+
+  /// process the completion records left by async jobs, O(completed)
+  ///
+  /// NOTE: a record pushed while another thread consumes completions_m is
+  /// left to that one, it checks again once it releases reap_mtx_m
+  void reap_completions()
+  {
+    while (completions_m.size() > 0)
+    {
+      auto done = std::vector<completion>{};
+
+      {
+        // many dispatcher workers may exec, one at a time consumes them
+        auto lock = std::unique_lock{reap_mtx_m, std::try_to_lock};
+
+        if (!lock)
+          return;
+
+        while (auto c = completions_m.try_pop())
+          done.push_back(std::move(*c));
+      }
+
+      // pushed but not linked yet, its pool thread wakes a reaper once it is
+      if (done.empty())
+        return;
+
+      for (auto& c : done)
+      {
+        if (c.e_ptr)
+        {
+          pars::debug(SL, lf::event,
+                      "Job #{}: Throws, processing exceptions !!", c.j_id);
+
+          process_exception(c.s_id, c.spec_hash, c.e_ptr);
+        }
+
+        pars::debug(SL, lf::event, "Job #{}: Done!", c.j_id);
+      }
+    }
+  }
+
+  /// run task on the worker pool, with a stop_token bound to the job
+  ///
+  /// once done, the task leaves a completion record to be reaped by exec,
+  /// or by whoever on_completion wakes
+  ///
+  /// with max_in_flight tasks of spec_hash already running, the task waits
+  /// parked until one of them completes; a stop request doesn't unpark it
+  void start_thread(std::size_t spec_hash, async_task_f task, job j,
+                    const std::size_t max_in_flight = 0)
+  {
+    auto c = completion{.j_id = j.id(),
+                        .s_id = j.socket_id(),
+                        .spec_hash = spec_hash,
+                        .e_ptr = nullptr,
+                        .key = {}};
+
+    // the options are set by now, the first async job starts the pool
+    std::call_once(pool_started_m, [this]() {
+      pool_m.start(num_async_workers_m, async_placement_m,
+                   [shard = shard_m]() { this_shard() = shard; });
+    });
 
     auto guard = std::lock_guard{mtx_m};
 
-    futures_m.emplace_back(j_id, s_id, spec_hash, task.get_future());
+    if (async_keys_m.contains(c.j_id))
+      return;
+
+    c.key = async_jobs_m.emplace(c.j_id, j.pipe_key());
+
+    async_keys_m.emplace(c.j_id, c.key);
+
+    // the pipe of j may be gone already
+    if (auto* jobs = pipes_m.find(j.pipe_key()))
+      jobs->push_back(c.key);
+
+    auto tk = async_jobs_m.find(c.key)->src.get_token();
+
+    // a task capturing just a frame is small enough not to allocate
+    auto* f = frames_m.make(std::move(c), std::move(task), std::move(j), tk);
+
+    if (max_in_flight > 0)
+    {
+      auto& b = bulkheads_m[spec_hash];
 
-    auto th_res = threads_m.try_emplace(j_id, std::move(task), std::move(j));
+      b.max_in_flight = max_in_flight;
 
-    if (!th_res.second)
-      futures_m.pop_back();
+      if (b.running >= b.max_in_flight)
+      {
+        pars::debug(SL, lf::event,
+                    "Job #{}: Parked, {} of Spec 0x{:X} already running",
+                    f->c.j_id, b.running, spec_hash);
+
+        b.parked.push_back(f);
+
+        ++num_parked_m;
+
+        return;
+      }
+
+      ++b.running;
+    }
+
+    pool_m.submit([this, f]() { run_frame(f); });
   }
 
+  /// async jobs waiting for their spec to run less than max_in_flight
+  std::size_t count_parked() const { return num_parked_m; }
+
+  /// recycling of async frames and completion records
+  pool_stats frame_stats() const { return frames_m.stats(); }
+
+  pool_stats completion_stats() const { return completions_m.node_stats(); }
+
   auto count_threads()
   {
     auto guard = std::lock_guard{mtx_m};
 
-    return futures_m.size();
+    return async_jobs_m.size();
   }
 
+  /// request all async jobs to stop and wait for them to complete
   void stop_all_threads()
   {
-    auto guard = std::lock_guard{mtx_m};
-
-    for (const auto& t : threads_m)
     {
-      if (stop_possible(t.first))
-        request_stop(t.first);
-    }
+      auto lock = std::unique_lock{mtx_m};
+
+      async_jobs_m.for_each([](auto, async_job& a) { a.src.request_stop(); });
+
+      completed_cond_m.wait(lock, [this]() { return async_jobs_m.empty(); });
 
-    while (!futures_m.empty())
-      process_futures();
+      pipes_m.clear();
 
-    pipe_jobs_m.clear();
+      pipe_keys_m.clear();
+    }
+
+    reap_completions();
   }
 
   bool can_exec(int s_id, std::size_t spec_hash)
   {
-    auto lock = hf_registry_m.lock();
-
     return hf_registry_m.has_handler_for(s_id, spec_hash);
   }
 
+  /// decode a received<nngxx::msg> job into the received<event_t> its
+  /// handler takes, on the calling thread
+  ///
+  /// without an handler, or if decoding fails, j is left as is: exec reports
+  /// the error as usual
+  void decode(job& j) const
+  {
+    auto spec_hash = j.spec_hash();
+
+    auto decoder = hf_registry_m.decoder_for(spec_hash);
+
+    if (!decoder || !hf_registry_m.has_handler_for(j.socket_id(), spec_hash))
+      return;
+
+    try
+    {
+      decoder(j);
+    }
+    catch (...)
+    {
+      pars::debug(SL, lf::event, "Job #{}: Unable to decode early, skip ...",
+                  j.id());
+    }
+  }
+
+  /// what is known of spec_hash, nullopt if never registered
+  std::optional<kind_info> info_for(std::size_t spec_hash) const
+  {
+    return hf_registry_m.info_for(spec_hash);
+  }
+
+  /// whether spec_hash has an handler on s_id that executes::inline_io
+  bool runs_inline(int s_id, std::size_t spec_hash) const
+  {
+    return hf_registry_m.runs_inline(spec_hash) &&
+           hf_registry_m.has_handler_for(s_id, spec_hash);
+  }
+
   void exec(job j)
   {
     auto spec_hash = j.spec_hash();
 
     auto s_id = j.socket_id();
 
-    auto lock = hf_registry_m.lock();
+    // coroutine handlers are resumed by their own frame, not by a handler
+    if (spec_hash == spec<fired<resumed>>::hash)
+    {
+      resume(std::move(j));
+
+      return;
+    }
+
+    // statically known handlers first, then the ones inserted with on<>()
+    auto [self, static_fn] = hf_registry_m.static_handler_for(s_id, spec_hash);
 
-    if (!hf_registry_m.has_handler_for(s_id, spec_hash))
+    auto* hf =
+      static_fn ? nullptr : hf_registry_m.handler_for(s_id, spec_hash);
+
+    if (!static_fn && !hf)
     {
       pars::err(SL, lf::event,
                 "Unable to find handler for Spec 0x{:X} on Socket {}, skip "
@@ -116,29 +328,37 @@ public:
       return;
     }
 
-    auto& hf = hf_registry_m.handler_for(s_id, spec_hash);
+    pars::debug(SL, lf::event, "Job #{}: Running Handler [{}]", j.id(),
+                demangled{hf_registry_m.type_for(spec_hash)->name()});
 
-    lock.unlock();
+    reap_completions();
 
-    pars::debug(SL, lf::event, "Job #{}: Running Handler [{}]", j.id(),
-                demangle(hf_registry_m.type_for(spec_hash)->name()));
+    auto& tc = task_context::current();
 
-    try
-    {
-      {
-        auto guard = std::lock_guard{mtx_m};
+    tc.s_id = s_id;
 
-        process_futures();
-      }
+    tc.spec_hash = spec_hash;
+
+    tc.p_id = j.pipe_id();
 
-      hf(std::move(j));
+    try
+    {
+      if (static_fn)
+        static_fn(self, std::move(j));
+      else
+        (*hf)(std::move(j));
     }
     catch (...)
     {
-      process_exception(s_id, spec_hash);
+      process_exception(s_id, spec_hash, std::current_exception());
     }
+
+    process_task_failure();
   }
 
+  /// coroutine frames allocated from the pools, see task
+  pool_stats task_frame_stats() const { return frame_pool::stats(); }
+
   template<template<typename> typename kind_of, event_c event_t>
     requires kind_c<kind_of>
   void exec(kind_of<event_t> ke)
@@ -146,123 +366,244 @@ public:
     exec(make_job(next_job_id(), std::move(ke)));
   }
 
+  /// exec ke on the calling nng I/O thread, see executes::inline_io
+  template<template<typename> typename kind_of, event_c event_t>
+    requires kind_c<kind_of>
+  void exec_inline(kind_of<event_t> ke)
+  {
+#ifdef NDEBUG
+    exec(std::move(ke));
+#else
+    auto start = std::chrono::steady_clock::now();
+
+    auto j = make_job(next_job_id(), std::move(ke));
+
+    auto j_id = j.id();
+
+    auto spec_hash = j.spec_hash();
+
+    exec(std::move(j));
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+
+    if (elapsed > inline_io_budget)
+      pars::warn(SL, lf::event,
+                 "Job #{}: Inline Handler [{}] held the I/O thread for {}us!",
+                 j_id, demangle(hf_registry_m.type_for(spec_hash)->name()),
+                 elapsed.count());
+#endif
+  }
+
   void add_pipe(const net::pipe& p)
   {
     auto guard = std::lock_guard{mtx_m};
 
     auto p_id = p.id();
 
-    pipe_jobs_m.insert({p_id, {}});
+    if (!pipe_keys_m.contains(p_id))
+      pipe_keys_m.emplace(p_id, pipes_m.emplace());
   }
 
-  /// stop all running and remove all pending jobs for pipe p
+  /// stop all running jobs for pipe p, the key of p gets stale
   void remove_pipe(const net::pipe& p)
   {
     auto guard = std::lock_guard{mtx_m};
 
-    auto p_id = p.id();
+    auto it = pipe_keys_m.find(p.id());
+
+    if (it == pipe_keys_m.end())
+      return;
 
-    if (!pipe_jobs_m.at(p_id).empty())
+    if (auto* jobs = pipes_m.find(it->second))
     {
-      // stop all running jobs for pipe p
-      stop_runnings(pipe_jobs_m.at(p_id));
+      for (auto key : *jobs)
+        request_stop(key);
     }
 
-    pipe_jobs_m.erase(p_id);
+    pipes_m.erase(it->second);
+
+    pipe_keys_m.erase(it);
   }
 
-  void associate_job_to_pipe(const int j_id, const int p_id)
+  /// the key of the pipe a job is associated with, stale once the pipe is
+  /// removed; a null key, never alive, if p_id was already removed or never
+  /// added, see job::pipe_alive
+  watched_key associate_job_to_pipe(const int j_id, const int p_id)
   {
     if (j_id <= 0)
       throw std::runtime_error(fmt::format("Job #{}: invalid Job!", p_id));
 
     if (p_id <= 0)
-      return;
+      return {};
 
     auto guard = std::lock_guard{mtx_m};
 
-    // add j_id to the jobs related to p, unless p was removed with a previous
-    // call to remove_pipe(p) (ie: pipe_jobs_m does not contains p.id())
-    if (pipe_jobs_m.contains(p_id))
-    {
-      pipe_jobs_m.at(p_id).push_back(j_id);
+    auto it = pipe_keys_m.find(p_id);
 
-      pars::debug(SL, lf::event,
-                  "Job #{} pushed and associated to Pipe {:X} [# size: {}]",
-                  j_id, p_id, pipe_jobs_m.at(p_id).size());
-    }
+    if (it == pipe_keys_m.end())
+      return {};
+
+    pars::debug(SL, lf::event, "Job #{} associated to Pipe {:X}", j_id, p_id);
+
+    return pipes_m.watch(it->second);
   }
 
   void stop_thread(const int j_id)
   {
     auto guard = std::lock_guard(mtx_m);
 
-    if (stop_possible(j_id))
-      request_stop(j_id);
+    if (auto it = async_keys_m.find(j_id); it != async_keys_m.end())
+      request_stop(it->second);
   }
 
 private:
-  std::unordered_set<std::size_t> stop_runnings(std::vector<std::size_t> j_ids)
+  /// how long an inline_io handler may run before debug builds warn
+  static constexpr auto inline_io_budget = std::chrono::milliseconds{1};
+
+  /// a running async job
+  struct async_job
   {
-    std::unordered_set<std::size_t> pending_jobs;
+    async_job(std::size_t id, slot_key p_key)
+      : j_id{id}
+      , pipe_key{p_key}
+    {
+    }
 
-    for (const auto& j_id : j_ids)
+    std::size_t j_id;
+    slot_key pipe_key;
+    std::stop_source src;
+  };
+
+  /// what's left of an async job once done
+  struct completion
+  {
+    std::size_t j_id;
+    int s_id;
+    std::size_t spec_hash;
+    std::exception_ptr e_ptr; ///< what the job has thrown, if anything
+    slot_key key;             ///< the key of the job in async_jobs_m
+  };
+
+  /// what an async job needs while running, kept in frames_m
+  struct async_frame
+  {
+    completion c;
+    async_task_f task;
+    job j;
+    std::stop_token tk;
+  };
+
+  /// called by the pool thread to execute the async job
+  void run_frame(async_frame* f)
+  {
+    try
     {
-      if (thread_running(j_id))
-      {
-        // stop running job, if possible
-        if (stop_possible(j_id))
-          request_stop(j_id);
-      }
-      else
-      {
-        pending_jobs.insert(j_id);
-      }
+      f->task(f->tk, std::move(f->j));
+    }
+    catch (...)
+    {
+      f->c.e_ptr = std::current_exception();
     }
 
-    return pending_jobs;
+    // a coroutine handler can't suspend here, see task
+    auto& tc = task_context::current();
+
+    if (auto failed = std::exchange(tc.failed, std::nullopt))
+      f->c.e_ptr = failed->e_ptr;
+
+    auto c = std::move(f->c);
+
+    frames_m.destroy(f);
+
+    complete(std::move(c));
   }
 
-  void process_futures()
+  /// resume the coroutine handler of j, where it was suspended
+  void resume(job j)
   {
-    for (auto it = futures_m.begin(); it != futures_m.end();)
-    {
-      using namespace std::chrono_literals;
+    auto ke = j.event<fired, resumed>();
 
-      auto& [j_id, s_id, spec_hash, f] = *it;
+    pars::debug(SL, lf::event, "Job #{}: Resuming {}", j.id(), ke.event());
 
-      if (f.wait_for(0ms) == std::future_status::ready)
-      {
-        try
-        {
-          f.get();
-        }
-        catch (...)
-        {
-          pars::debug(SL, lf::event,
-                      "Job #{}: Throws, processing exceptions !!", j_id);
+    // it may suspend again, on the same pipe
+    task_context::current().p_id = j.pipe_id();
 
-          process_exception(s_id, spec_hash);
-        }
+    ke.event().handle.resume();
 
-        threads_m.erase(j_id);
+    process_task_failure();
+  }
 
-        pars::debug(SL, lf::event, "Job #{}: Done! [# futures: {}]", j_id,
-                    futures_m.size());
+  /// what a coroutine handler threw, as if thrown by its handler
+  void process_task_failure()
+  {
+    if (auto f = std::exchange(task_context::current().failed, std::nullopt))
+      process_exception(f->s_id, f->spec_hash, f->e_ptr);
+  }
 
-        it = futures_m.erase(it);
-      }
-      else
-      {
-        ++it;
-      }
+  /// called by the pool thread that executed the async job
+  void complete(completion c)
+  {
+    auto key = c.key;
+
+    auto spec_hash = c.spec_hash;
+
+    completions_m.push(std::move(c));
+
+    // without further jobs to exec, nobody else would reap it; called while
+    // the job is still running for stop_all_threads, the dispatcher may be
+    // gone once it returns
+    if (on_completion_m)
+      on_completion_m();
+
+    auto guard = std::lock_guard{mtx_m};
+
+    if (auto* a = async_jobs_m.find(key))
+    {
+      if (auto* jobs = pipes_m.find(a->pipe_key))
+        std::erase(*jobs, key);
+
+      async_keys_m.erase(a->j_id);
+
+      async_jobs_m.erase(key);
     }
+
+    if (async_jobs_m.empty())
+      completed_cond_m.notify_all();
+
+    unpark(spec_hash);
   }
 
-  void process_exception(auto s_id, auto spec_hash)
+  /// a job of spec_hash completed, its place goes to the next parked one
+  ///
+  /// NOTE: called with mtx_m held
+  void unpark(const std::size_t spec_hash)
   {
-    auto e_ptr = std::current_exception();
+    auto it = bulkheads_m.find(spec_hash);
 
+    if (it == bulkheads_m.end())
+      return;
+
+    auto& b = it->second;
+
+    if (b.parked.empty())
+    {
+      --b.running;
+
+      return;
+    }
+
+    auto* f = b.parked.front();
+
+    b.parked.pop_front();
+
+    --num_parked_m;
+
+    pool_m.submit([this, f]() { run_frame(f); });
+  }
+
+  void process_exception(auto s_id, auto spec_hash, std::exception_ptr e_ptr)
+  {
     try
     {
       std::rethrow_exception(e_ptr);
@@ -280,18 +621,22 @@ private:
 
     auto e_hash = spec<fired<exception>>::hash;
 
-    auto lock = hf_registry_m.lock();
-
-    if (!hf_registry_m.has_handler_for(s_id, e_hash))
-      return;
+    // statically known handlers first, as in exec
+    auto [self, static_fn] = hf_registry_m.static_handler_for(s_id, e_hash);
 
-    auto& hf = hf_registry_m.handler_for(s_id, e_hash);
+    auto* hf = static_fn ? nullptr : hf_registry_m.handler_for(s_id, e_hash);
 
-    lock.unlock();
+    if (!static_fn && !hf)
+      return;
 
     try
     {
-      hf(make_job(next_job_id(), fired{exception{e_ptr}, {}}));
+      auto j = make_job(next_job_id(), fired{exception{e_ptr}, {}});
+
+      if (static_fn)
+        static_fn(self, std::move(j));
+      else
+        (*hf)(std::move(j));
     }
     catch (std::exception& e)
     {
@@ -306,39 +651,52 @@ private:
     }
   }
 
-  void request_stop(const std::size_t j_id)
+  void request_stop(const slot_key key)
   {
-    threads_m[j_id].get_stop_source().request_stop();
+    if (auto* a = async_jobs_m.find(key); a && a->src.stop_possible())
+      a->src.request_stop();
   }
 
-  bool thread_running(const std::size_t j_id)
-  {
-    return threads_m.contains(j_id);
-  }
+  std::mutex mtx_m; ///< protects async and pipe tables
+  std::condition_variable completed_cond_m; ///< async_jobs_m got empty
 
-  bool stop_possible(const std::size_t j_id)
-  {
-    return threads_m[j_id].get_stop_token().stop_possible();
-  }
+  slot_map<async_job> async_jobs_m; ///< running async jobs
+  std::unordered_map<std::size_t, slot_key>
+    async_keys_m; ///< async job id to its key, for stop_thread
+
+  slot_map<std::vector<slot_key>>
+    pipes_m; ///< keys of the running async jobs of each pipe
+  std::unordered_map<int, slot_key>
+    pipe_keys_m; ///< pipe id, as assigned by nng, to its key
 
-  std::mutex mtx_m; ///< protects futures_m, threads_m
+  /// the async jobs of a spec with max_in_flight
+  struct bulkhead
+  {
+    std::size_t max_in_flight{0};
+    std::size_t running{0};
+    std::deque<async_frame*> parked; ///< waiting for a running one
+  };
 
-  using futures_value_type =
-    std::tuple<std::size_t, int, std::size_t, std::future<void>>;
+  std::unordered_map<std::size_t, bulkhead>
+    bulkheads_m; ///< by spec hash, only for the limited ones
+  std::atomic<std::size_t> num_parked_m{0};
 
-  std::vector<futures_value_type>
-    futures_m; ///< all job ids, socket ids, spec hashes
-               ///< and futures from threads that are running
+  mpsc_queue<completion> completions_m; ///< done async jobs, to be reaped
+  std::mutex reap_mtx_m;                ///< one consumer of completions_m
+  std::function<void()> on_completion_m; ///< a completion record was left
 
-  std::unordered_map<std::size_t, std::jthread>
-    threads_m; ///< the jthread for a given job id, if any
+  object_pool<async_frame> frames_m; ///< recycled, outlives pool_m
 
   hf_registry& hf_registry_m;
 
-  std::unordered_map<int, std::vector<std::size_t>>
-    pipe_jobs_m; ///< all queued ids of jobs for a given pipe id
+  std::atomic<std::size_t> next_job_id_m{1}; ///< 0 is never a valid job id
 
-  std::atomic<std::size_t> next_job_id_m{0};
+  std::size_t num_async_workers_m{
+    std::max(1u, std::thread::hardware_concurrency())};
+  thread_placement async_placement_m;
+  std::optional<std::size_t> shard_m; ///< set by shard, if any
+  std::once_flag pool_started_m;
+  worker_pool pool_m; ///< executes async jobs, destroyed first
 };
 
 } // namespace pars::ev
@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/ev/dispatcher.h"
+#include "pars/ev/hf_registry.h"
+#include "pars/ev/runner.h"
+#include "pars/ev/timer.h"
+
+#include <memory>
+
+namespace pars::ev
+{
+
+/**
+ * @brief A dispatcher with its own runner and hf_registry
+ *
+ * Shards share nothing but the handler functions, cloned into their own
+ * hf_registry: each of them owns its queue, its jobs, its timers and its
+ * threads.
+ */
+class shard
+{
+public:
+  /// shard_idx is the index of the shard in the enqueuer routing to it
+  shard(const std::size_t shard_idx = 0)
+    : hf_registry_m{*std::addressof(runner_m)}
+    , runner_m{hf_registry_m}
+    , dispatcher_m{runner_m}
+    , timer_m{dispatcher_m}
+  {
+    runner_m.set_shard(shard_idx);
+
+    dispatcher_m.set_shard(shard_idx);
+  }
+
+  shard(const shard&) = delete;
+
+  shard& operator=(const shard&) = delete;
+
+  ev::runner& runner() { return runner_m; }
+
+  ev::hf_registry& hfs() { return hf_registry_m; }
+
+  ev::dispatcher& dispatcher() { return dispatcher_m; }
+
+  ev::timer& timers() { return timer_m; }
+
+private:
+  // NOTE: hf_registry only keeps the address of runner_m, built right after
+  ev::hf_registry hf_registry_m;
+  ev::runner runner_m;
+  ev::dispatcher dispatcher_m;
+  ev::timer timer_m;
+};
+
+} // namespace pars::ev
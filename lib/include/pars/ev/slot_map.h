@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace pars::ev
+{
+
+/// a handle to a value of a slot_map, stale once the value is erased
+struct slot_key
+{
+  std::uint32_t index = 0;
+  std::uint32_t generation = 0; ///< 0 is never used by a slot_map
+
+  explicit operator bool() const { return generation != 0; }
+
+  bool operator==(const slot_key&) const = default;
+};
+
+/// a slot_key whose staleness is checked from any thread, see slot_map::watch
+struct watched_key
+{
+  slot_key key;
+  const std::atomic<std::uint32_t>* generation = nullptr; ///< of its slot
+
+  /// false once the value of key is erased, or if it never had one
+  bool alive() const
+  {
+    return generation &&
+           generation->load(std::memory_order_acquire) == key.generation;
+  }
+};
+
+/**
+ * @brief A generational slot map
+ *
+ * Values are reached by slot_key in O(1), by indexing an array of slots.
+ * Every slot has a generation, bumped when its value is erased, that makes
+ * keys of erased values stale: find returns nullptr for them, even once the
+ * slot is reused.
+ *
+ * Values never move, a reference stays valid until the value is erased.
+ *
+ * @note not thread safe, but for the generations handed out by watch
+ */
+template<typename value_t>
+class slot_map
+{
+public:
+  using value_type = value_t;
+  using key = slot_key;
+
+  slot_map() = default;
+
+  slot_map(const slot_map&) = delete;
+
+  slot_map& operator=(const slot_map&) = delete;
+
+  template<typename... args_t>
+  key emplace(args_t&&... args)
+  {
+    auto index = std::uint32_t{0};
+
+    if (free_m.empty())
+    {
+      index = static_cast<std::uint32_t>(slots_m.size());
+
+      slots_m.emplace_back();
+    }
+    else
+    {
+      index = free_m.back();
+
+      free_m.pop_back();
+    }
+
+    auto& s = slots_m[index];
+
+    s.value.emplace(std::forward<args_t>(args)...);
+
+    ++size_m;
+
+    return {index, s.generation.load(std::memory_order_relaxed)};
+  }
+
+  /// erase the value of k, false if k is stale
+  bool erase(const key k)
+  {
+    auto* s = slot_of(k);
+
+    if (!s)
+      return false;
+
+    s->value.reset();
+
+    auto generation = s->generation.load(std::memory_order_relaxed) + 1;
+
+    s->generation.store(generation == 0 ? 1 : generation,
+                        std::memory_order_release);
+
+    free_m.push_back(k.index);
+
+    --size_m;
+
+    return true;
+  }
+
+  /// the value of k, nullptr if k is stale
+  value_type* find(const key k)
+  {
+    auto* s = slot_of(k);
+
+    return s ? &*s->value : nullptr;
+  }
+
+  const value_type* find(const key k) const
+  {
+    return const_cast<slot_map*>(this)->find(k);
+  }
+
+  bool contains(const key k) const { return find(k) != nullptr; }
+
+  /// k along with the generation of its slot, that tells lock-free when k
+  /// gets stale: slots outlive their values, until the slot_map is destroyed
+  watched_key watch(const key k) const
+  {
+    auto* s = const_cast<slot_map*>(this)->slot_of(k);
+
+    return s ? watched_key{k, &s->generation} : watched_key{};
+  }
+
+  /// call f(key, value&) for every value
+  template<typename f_t>
+  void for_each(f_t&& f)
+  {
+    for (auto i = std::size_t{0}; i < slots_m.size(); ++i)
+    {
+      auto& s = slots_m[i];
+
+      if (s.value)
+        f(key{static_cast<std::uint32_t>(i),
+              s.generation.load(std::memory_order_relaxed)},
+          *s.value);
+    }
+  }
+
+  void clear()
+  {
+    for (auto i = std::size_t{0}; i < slots_m.size(); ++i)
+      erase(key{static_cast<std::uint32_t>(i),
+                slots_m[i].generation.load(std::memory_order_relaxed)});
+  }
+
+  std::size_t size() const { return size_m; }
+
+  bool empty() const { return size_m == 0; }
+
+private:
+  struct slot
+  {
+    std::atomic<std::uint32_t> generation{1}; ///< read lock-free, see watch
+    std::optional<value_type> value;
+  };
+
+  slot* slot_of(const key k)
+  {
+    if (k.index >= slots_m.size())
+      return nullptr;
+
+    auto& s = slots_m[k.index];
+
+    if (s.generation.load(std::memory_order_relaxed) != k.generation ||
+        !s.value)
+      return nullptr;
+
+    return &s;
+  }
+
+  std::deque<slot> slots_m; ///< a deque, values don't move while growing
+  std::vector<std::uint32_t> free_m; ///< indexes of the empty slots
+  std::size_t size_m{0};
+};
+
+} // namespace pars::ev
@@ -0,0 +1,253 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/ev/klass.h"
+#include "pars/ev/object_pool.h"
+
+#include <fmt/format.h>
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace pars::ev
+{
+
+/// a coroutine handler is resumed, see task
+struct resumed
+{
+  std::coroutine_handle<> handle;
+  int pipe_id = 0; ///< the pipe of the job suspended, resumed on its strand
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "resumed({}, {:X})", handle.address(),
+                          pipe_id);
+  }
+};
+
+template<>
+struct klass<resumed> : base_klass<resumed>
+{
+  static constexpr std::string_view uuid =
+    "6d2f8a41-c3e5-4b97-9a0d-1e7c5b3f8d26";
+
+  static constexpr bool requires_network = false;
+
+  /// never purged, shed nor expired: the frame would not be resumed
+  static constexpr ev::priority priority = ev::priority::control;
+};
+
+/**
+ * @brief The coroutine handlers running on the calling thread
+ *
+ * The runner tells which handler it runs, coroutines remember it to report
+ * their exceptions as the ones of that handler, even once resumed; awaitables
+ * remember the pipe, to resume on its strand.
+ */
+struct task_context
+{
+  int s_id = 0;              ///< the socket of the handler running
+  std::size_t spec_hash = 0; ///< the spec of the handler running
+  int p_id = 0;              ///< the pipe of the job running, 0 if none
+
+  /// what a coroutine threw, with its socket and spec
+  struct failure
+  {
+    int s_id = 0;
+    std::size_t spec_hash = 0;
+    std::exception_ptr e_ptr;
+  };
+
+  std::optional<failure> failed; ///< taken by the runner
+
+  static task_context& current()
+  {
+    thread_local auto ctx = task_context{};
+
+    return ctx;
+  }
+};
+
+/// @name Frames
+///
+/// Coroutine frames are allocated in a few size classes, each one a
+/// recycling object_pool; larger frames use operator new.
+
+/// the memory of a coroutine frame, up to size bytes
+template<std::size_t size>
+struct frame_block
+{
+  alignas(std::max_align_t) std::byte bytes[size];
+};
+
+class frame_pool
+{
+public:
+  static constexpr std::size_t max_pooled = 2048;
+
+  static void* allocate(const std::size_t n)
+  {
+    void* p = nullptr;
+
+    if (!for_class(n, [&](auto& pool) { p = pool.make(); }))
+      p = ::operator new(n);
+
+    return p;
+  }
+
+  static void deallocate(void* p, const std::size_t n) noexcept
+  {
+    if (!for_class(n, [&](auto& pool) {
+          using block = std::remove_reference_t<decltype(pool)>::value_type;
+
+          pool.destroy(static_cast<block*>(p));
+        }))
+      ::operator delete(p, n);
+  }
+
+  /// frames allocated from the pools
+  static pool_stats stats()
+  {
+    auto s = pool_stats{};
+
+    s += pool<256>().stats();
+    s += pool<512>().stats();
+    s += pool<1024>().stats();
+    s += pool<max_pooled>().stats();
+
+    return s;
+  }
+
+private:
+  template<std::size_t size>
+  static object_pool<frame_block<size>>& pool()
+  {
+    static auto p = object_pool<frame_block<size>>{};
+
+    return p;
+  }
+
+  /// call f with the pool of the smallest class fitting n, false if none
+  template<typename f_t>
+  static bool for_class(const std::size_t n, f_t&& f)
+  {
+    if (n <= 256)
+      f(pool<256>());
+    else if (n <= 512)
+      f(pool<512>());
+    else if (n <= 1024)
+      f(pool<1024>());
+    else if (n <= max_pooled)
+      f(pool<max_pooled>());
+    else
+      return false;
+
+    return true;
+  }
+};
+
+template<typename value_t = void>
+class task;
+
+/**
+ * @brief The return type of coroutine handlers
+ *
+ * A handler returning task<> starts like any other handler, and runs up to
+ * its first co_await on an awaitable of pars: net::context::send,
+ * net::context::recv and ev::sleep. Once the operation awaited completes,
+ * the handler is resumed by a job of the dispatcher that suspended it, so
+ * that a request/reply round trip reads as a single function:
+ *
+ * @code
+ * task<> ask(hf_arg<fired, init>)
+ * {
+ *   co_await ctx.send(fib_requested{1, 32});
+ *
+ *   auto reply = co_await ctx.recv<fib_computed>();
+ * }
+ * @endcode
+ *
+ * The coroutine is detached, its frame is destroyed once it returns. Only
+ * handlers running on a dispatcher worker may suspend: async and inline_io
+ * ones get an exception. A coroutine suspended when the dispatcher stops is
+ * never resumed.
+ *
+ * Exceptions are processed like the ones of the handler that started the
+ * coroutine.
+ *
+ * @note value_t is reserved, only task<> is provided for now
+ */
+template<>
+class task<void>
+{
+public:
+  struct promise_type
+  {
+    task get_return_object() noexcept { return {}; }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() noexcept
+    {
+      task_context::current().failed =
+        task_context::failure{s_id, spec_hash, std::current_exception()};
+    }
+
+    static void* operator new(const std::size_t n)
+    {
+      return frame_pool::allocate(n);
+    }
+
+    static void operator delete(void* p, const std::size_t n) noexcept
+    {
+      frame_pool::deallocate(p, n);
+    }
+
+    int s_id = task_context::current().s_id;
+    std::size_t spec_hash = task_context::current().spec_hash;
+  };
+};
+
+/// what a handler function returns: nothing, or task<> if a coroutine
+template<typename return_t>
+concept handler_return_c =
+  std::is_void_v<return_t> || std::is_same_v<return_t, task<>>;
+
+} // namespace pars::ev
@@ -0,0 +1,189 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/log.h"
+
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace pars::ev
+{
+
+/**
+ * @brief Where the threads of a group run, and how they're named
+ *
+ * Applied by each thread to itself, as soon as it starts and before it
+ * allocates its own structures: with the default first-touch policy of
+ * Linux, their memory lands on the NUMA node of the CPUs the thread is
+ * pinned to.
+ *
+ * @note honored on Linux only, elsewhere threads are left as they are
+ */
+struct thread_placement
+{
+  std::string name{};      ///< threads are named name-index, up to 15 chars
+  std::vector<int> cpus{}; ///< CPUs the threads may run on, empty for any
+  bool pin_each{false};    ///< thread i runs on cpus[i % cpus.size()] only
+
+  /// throws if a CPU can't be part of a CPU set
+  void validate() const
+  {
+    for (auto cpu : cpus)
+    {
+#if defined(__linux__)
+      if (cpu < 0 || cpu >= CPU_SETSIZE)
+#else
+      if (cpu < 0)
+#endif
+        throw std::invalid_argument(fmt::format("Invalid CPU {}!", cpu));
+    }
+  }
+
+  bool operator==(const thread_placement&) const = default;
+};
+
+/// apply p to the calling thread, the idx-th of its group
+inline void place_this_thread(const thread_placement& p, const std::size_t idx)
+{
+#if defined(__linux__)
+  auto name = fmt::format("{}-{}", p.name, idx);
+
+  // the kernel keeps 15 chars plus the terminator
+  if (!p.name.empty())
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+  if (p.cpus.empty())
+    return;
+
+  auto set = cpu_set_t{};
+
+  CPU_ZERO(&set);
+
+  if (p.pin_each)
+    CPU_SET(p.cpus[idx % p.cpus.size()], &set);
+  else
+    for (auto cpu : p.cpus)
+      CPU_SET(cpu, &set);
+
+  if (auto err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+    pars::warn(SL, lf::event, "Unable to pin Thread {}: {}", name,
+               std::strerror(err));
+#else
+  if (!p.name.empty() || !p.cpus.empty())
+    pars::debug(SL, lf::event, "Thread placement is not supported, skip ...");
+#endif
+}
+
+/**
+ * @brief Saves the name and the CPUs of the calling thread, restores them
+ * when destroyed
+ *
+ * For a thread placed only for a while, eg: the one calling dispatcher::run
+ * is placed as its first worker until run returns.
+ *
+ * @note destroy it on the thread that created it
+ */
+class placement_guard
+{
+public:
+  placement_guard()
+  {
+#if defined(__linux__)
+    saved_m =
+      pthread_getname_np(pthread_self(), name_m, sizeof(name_m)) == 0 &&
+      pthread_getaffinity_np(pthread_self(), sizeof(cpus_m), &cpus_m) == 0;
+#endif
+  }
+
+  placement_guard(const placement_guard&) = delete;
+
+  placement_guard& operator=(const placement_guard&) = delete;
+
+  ~placement_guard()
+  {
+#if defined(__linux__)
+    if (!saved_m)
+      return;
+
+    pthread_setname_np(pthread_self(), name_m);
+
+    if (auto err =
+          pthread_setaffinity_np(pthread_self(), sizeof(cpus_m), &cpus_m))
+      pars::warn(SL, lf::event, "Unable to restore Thread {}: {}", name_m,
+                 std::strerror(err));
+#endif
+  }
+
+private:
+#if defined(__linux__)
+  char name_m[16]{};   ///< the kernel keeps 15 chars plus the terminator
+  cpu_set_t cpus_m{};  ///< CPUs the thread could run on
+  bool saved_m{false}; ///< whether there's something to restore
+#endif
+};
+
+/// tell the CPU the calling thread is busy-waiting, so that it saves power and
+/// leaves resources to its sibling hyper-thread
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/// the index of the shard the calling thread works for, set as its dispatcher
+/// worker or async worker starts; nullopt on any other thread, eg: nng I/O
+/// threads, timers or threads of the application
+inline std::optional<std::size_t>& this_shard()
+{
+  static thread_local auto idx = std::optional<std::size_t>{};
+
+  return idx;
+}
+
+} // namespace pars::ev
@@ -0,0 +1,334 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/ev/dispatcher.h"
+#include "pars/ev/event.h"
+#include "pars/ev/kind.h"
+#include "pars/ev/slot_map.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pars::ev
+{
+
+/**
+ * @brief Timers firing fired<timer_expired<tag_t>> on a dispatcher
+ *
+ * A hashed hierarchical timing wheel: num_levels wheels of num_slots slots,
+ * every slot of a wheel spanning a whole turn of the wheel below. A timer
+ * waits in the wheel its expiry falls in, and moves down a wheel when the one
+ * below turns to its slot: arming and cancelling are O(1) whatever the number
+ * of timers, a tick only touches the timers due in it.
+ *
+ * Timers are driven by a thread of their own, started on the first arm and
+ * ticking every resolution while any timer is pending; expirations are queued
+ * at the back of the dispatcher, like any other fired event.
+ */
+class timer
+{
+public:
+  using key = slot_key; ///< a pending timer, stale once fired or cancelled
+
+  static constexpr std::chrono::microseconds default_resolution{1000};
+
+  timer(dispatcher& d,
+        const std::chrono::microseconds resolution = default_resolution)
+    : dispatcher_m{d}
+    , resolution_m{resolution}
+  {
+    if (resolution_m.count() <= 0)
+      throw std::invalid_argument("Timer resolution must be positive!");
+  }
+
+  timer(const timer&) = delete;
+
+  timer& operator=(const timer&) = delete;
+
+  /// fire fired<timer_expired<tag_t>>, carrying tag, once delay elapsed;
+  /// rounded up to the resolution
+  template<typename tag_t>
+    requires internal_event_c<timer_expired<tag_t>>
+  key arm(const std::chrono::microseconds delay, tag_t tag)
+  {
+    return arm_with(delay, [this, tag = std::move(tag)](
+                             const std::chrono::microseconds late) mutable {
+      dispatcher_m.queue_back(
+        fired{timer_expired<tag_t>{std::move(tag), late}, {}});
+    });
+  }
+
+  /// false if k already fired or was cancelled
+  bool cancel(const key k)
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    if (!entries_m.contains(k))
+      return false;
+
+    unlink(k);
+
+    entries_m.erase(k);
+
+    return true;
+  }
+
+  /// timers pending
+  std::size_t size()
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    return entries_m.size();
+  }
+
+  std::chrono::microseconds resolution() const { return resolution_m; }
+
+private:
+  using fire_f = std::move_only_function<void(std::chrono::microseconds)>;
+
+  static constexpr std::size_t slot_bits = 8;
+  static constexpr std::size_t num_slots = std::size_t{1} << slot_bits;
+  static constexpr std::size_t num_levels = 4;
+
+  /// ticks a timer may be armed ahead of now_m without wrapping the top wheel
+  static constexpr std::uint64_t max_ahead =
+    (std::uint64_t{1} << (slot_bits * num_levels)) - 1;
+
+  struct entry
+  {
+    std::uint64_t expiry; ///< in ticks since epoch_m
+    fire_f fire;
+    std::size_t bucket{0}; ///< level * num_slots + slot
+    key prev{};            ///< in the same bucket
+    key next{};
+  };
+
+  key arm_with(const std::chrono::microseconds delay, fire_f fire)
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    auto now = std::chrono::steady_clock::now();
+
+    if (!thread_m.joinable())
+    {
+      epoch_m = now;
+
+      thread_m = std::jthread{[this](std::stop_token tk) { run(tk); }};
+    }
+
+    // without timers the thread doesn't tick, nothing to fire in between
+    if (entries_m.empty())
+      now_m = std::max(now_m, ticks_to(now));
+
+    auto expiry = std::max(ticks_to(now + delay, true), now_m + 1);
+
+    auto k =
+      entries_m.emplace(entry{.expiry = expiry, .fire = std::move(fire)});
+
+    link(k);
+
+    cond_m.notify_one();
+
+    return k;
+  }
+
+  /// ticks from epoch_m to tp, rounded down or up
+  std::uint64_t ticks_to(const std::chrono::steady_clock::time_point tp,
+                         const bool round_up = false) const
+  {
+    auto d =
+      std::chrono::duration_cast<std::chrono::microseconds>(tp - epoch_m);
+
+    if (d.count() <= 0)
+      return 0;
+
+    auto n = static_cast<std::uint64_t>(d.count());
+    auto r = static_cast<std::uint64_t>(resolution_m.count());
+
+    return round_up ? (n + r - 1) / r : n / r;
+  }
+
+  /// put k in the wheel its expiry falls in, relative to now_m
+  ///
+  /// NOTE: called with mtx_m held
+  void link(const key k)
+  {
+    auto& e = *entries_m.find(k);
+
+    auto at = std::min(e.expiry, now_m + max_ahead);
+
+    auto level = std::size_t{0};
+
+    while (level + 1 < num_levels &&
+           at - now_m >= std::uint64_t{1} << (slot_bits * (level + 1)))
+      ++level;
+
+    e.bucket = level * num_slots + ((at >> (slot_bits * level)) % num_slots);
+
+    e.prev = {};
+
+    e.next = buckets_m[e.bucket];
+
+    if (e.next)
+      entries_m.find(e.next)->prev = k;
+
+    buckets_m[e.bucket] = k;
+  }
+
+  /// NOTE: called with mtx_m held
+  void unlink(const key k)
+  {
+    auto& e = *entries_m.find(k);
+
+    if (e.prev)
+      entries_m.find(e.prev)->next = e.next;
+    else
+      buckets_m[e.bucket] = e.next;
+
+    if (e.next)
+      entries_m.find(e.next)->prev = e.prev;
+  }
+
+  /// take every timer of bucket b out of the wheels
+  ///
+  /// NOTE: called with mtx_m held
+  std::vector<key> take(const std::size_t b)
+  {
+    auto ks = std::vector<key>{};
+
+    for (auto k = std::exchange(buckets_m[b], key{}); k;)
+    {
+      ks.push_back(k);
+
+      k = entries_m.find(k)->next;
+    }
+
+    return ks;
+  }
+
+  /// advance now_m by one tick, moving the timers due in it to due
+  ///
+  /// NOTE: called with mtx_m held
+  void tick(std::vector<std::pair<std::uint64_t, fire_f>>& due)
+  {
+    ++now_m;
+
+    // the wheels that turned to a new slot, from the highest one down
+    auto top = std::size_t{0};
+
+    while (top + 1 < num_levels &&
+           now_m % (std::uint64_t{1} << (slot_bits * (top + 1))) == 0)
+      ++top;
+
+    for (auto level = top; level > 0; --level)
+    {
+      auto slot = (now_m >> (slot_bits * level)) % num_slots;
+
+      for (auto k : take(level * num_slots + slot))
+        link(k);
+    }
+
+    for (auto k : take(now_m % num_slots))
+    {
+      auto& e = *entries_m.find(k);
+
+      due.emplace_back(e.expiry, std::move(e.fire));
+
+      entries_m.erase(k);
+    }
+  }
+
+  void run(std::stop_token tk)
+  {
+    auto lock = std::unique_lock{mtx_m};
+
+    auto due = std::vector<std::pair<std::uint64_t, fire_f>>{};
+
+    while (!tk.stop_requested())
+    {
+      if (entries_m.empty())
+      {
+        cond_m.wait(lock, tk, [this]() { return !entries_m.empty(); });
+
+        continue;
+      }
+
+      auto next = epoch_m + resolution_m * (now_m + 1);
+
+      if (std::chrono::steady_clock::now() < next)
+      {
+        cond_m.wait_until(lock, tk, next, []() { return false; });
+
+        continue;
+      }
+
+      // catch up with the ticks missed, if late
+      for (auto target = ticks_to(std::chrono::steady_clock::now());
+           now_m < target && !entries_m.empty();)
+        tick(due);
+
+      // NOTE: fire after mtx_m unlock, handlers may arm or cancel
+      lock.unlock();
+
+      auto now = std::chrono::steady_clock::now();
+
+      for (auto& [expiry, fire] : due)
+        fire(std::max(std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - (epoch_m + resolution_m * expiry)),
+                      std::chrono::microseconds{0}));
+
+      due.clear();
+
+      lock.lock();
+    }
+  }
+
+  dispatcher& dispatcher_m;
+  const std::chrono::microseconds resolution_m; ///< the length of a tick
+  std::mutex mtx_m; ///< guards everything below but thread_m
+  std::condition_variable_any cond_m;
+  slot_map<entry> entries_m; ///< pending timers
+  std::array<key, num_levels * num_slots> buckets_m{}; ///< list heads
+  std::chrono::steady_clock::time_point epoch_m; ///< tick 0
+  std::uint64_t now_m{0}; ///< ticks elapsed, due timers fired
+  std::jthread thread_m;  ///< NOTE: last, stopped before the rest goes
+};
+
+} // namespace pars::ev
@@ -0,0 +1,270 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "pars/ev/threading.h"
+#include "pars/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace pars::ev
+{
+
+/**
+ * @brief A fixed set of threads executing tasks
+ *
+ * Every worker owns a deque of tasks: a worker pops tasks from the front of
+ * its own deque and, once empty, steals from the back of the deques of the
+ * other workers. Tasks submitted by a worker go to its own deque, the others
+ * are spread round robin.
+ *
+ * Submitting locks just the deque the task goes to: the pool wide mutex is
+ * taken only to wake a sleeping worker up, if any.
+ */
+class worker_pool
+{
+public:
+  using task_type = std::move_only_function<void()>;
+
+  worker_pool() = default;
+
+  worker_pool(const worker_pool&) = delete;
+
+  worker_pool& operator=(const worker_pool&) = delete;
+
+  ~worker_pool() { stop(); }
+
+  /// start num_workers threads placed by p, unless already started
+  ///
+  /// every worker allocates its own deque once placed, see thread_placement;
+  /// on_start runs on each of them before, eg: to set thread_local state
+  void start(const std::size_t num_workers, const thread_placement& p = {},
+             std::function<void()> on_start = {})
+  {
+    auto lock = std::unique_lock{mtx_m};
+
+    if (!threads_m.empty())
+      return;
+
+    if (num_workers == 0)
+      throw std::invalid_argument("At least one worker is required!");
+
+    queues_m.resize(num_workers);
+
+    for (auto i = std::size_t{0}; i < num_workers; ++i)
+      threads_m.emplace_back([this, i, p, on_start]() {
+        place_this_thread(p, i);
+
+        if (on_start)
+          on_start();
+
+        place_queue(i, std::make_unique<worker_queue>());
+
+        work(i);
+      });
+
+    cond_m.wait(lock, [this]() { return num_placed_m == queues_m.size(); });
+
+    pars::debug(SL, lf::event, "Worker Pool started [# workers: {}]",
+                num_workers);
+  }
+
+  /// wait for all submitted tasks to run, then join the threads
+  void stop()
+  {
+    {
+      auto guard = std::lock_guard{mtx_m};
+
+      stopping_m = true;
+    }
+
+    cond_m.notify_all();
+
+    threads_m.clear();
+  }
+
+  /// tasks submitted but not yet taken by a worker
+  std::size_t pending() const { return pending_m; }
+
+  bool started()
+  {
+    auto guard = std::lock_guard{mtx_m};
+
+    return !threads_m.empty();
+  }
+
+  void submit(task_type t)
+  {
+    auto idx = worker_idx_m && owner_m == this
+                 ? *worker_idx_m
+                 : next_queue_m++ % queues_m.size();
+
+    {
+      auto& q = *queues_m[idx];
+
+      auto guard = std::lock_guard{q.mtx};
+
+      q.tasks.push_back(std::move(t));
+
+      pending_m.fetch_add(1);
+    }
+
+    wake_worker();
+  }
+
+private:
+  struct worker_queue
+  {
+    std::mutex mtx;
+    std::deque<task_type> tasks;
+  };
+
+  /// notify a sleeping worker, if any
+  ///
+  /// NOTE: a worker announces itself in sleeping_m before checking pending_m
+  /// for the last time, so either it sees the task or we see it sleeping
+  void wake_worker()
+  {
+    if (sleeping_m.load() == 0)
+      return;
+
+    // the worker releases mtx_m only once it's waiting on cond_m
+    {
+      auto guard = std::lock_guard{mtx_m};
+    }
+
+    cond_m.notify_one();
+  }
+
+  /// a worker can steal from the others only once they're all placed
+  void place_queue(const std::size_t idx, std::unique_ptr<worker_queue> q)
+  {
+    auto lock = std::unique_lock{mtx_m};
+
+    queues_m[idx] = std::move(q);
+
+    ++num_placed_m;
+
+    cond_m.notify_all();
+
+    cond_m.wait(lock, [this]() { return num_placed_m == queues_m.size(); });
+  }
+
+  void work(const std::size_t idx)
+  {
+    owner_m = this;
+
+    worker_idx_m = idx;
+
+    for (;;)
+    {
+      if (auto t = pop(idx))
+      {
+        (*t)();
+
+        continue;
+      }
+
+      auto lock = std::unique_lock{mtx_m};
+
+      sleeping_m.fetch_add(1);
+
+      cond_m.wait(lock, [&]() { return pending_m.load() > 0 || stopping_m; });
+
+      sleeping_m.fetch_sub(1);
+
+      if (stopping_m && pending_m.load() == 0)
+        return;
+    }
+  }
+
+  /// pop from the front of our deque, or steal from the back of another one
+  std::optional<task_type> pop(const std::size_t idx)
+  {
+    for (auto i = std::size_t{0}; i < queues_m.size(); ++i)
+    {
+      auto victim = (idx + i) % queues_m.size();
+
+      auto& q = *queues_m[victim];
+
+      auto guard = std::lock_guard{q.mtx};
+
+      if (q.tasks.empty())
+        continue;
+
+      auto t = std::optional<task_type>{};
+
+      if (victim == idx)
+      {
+        t.emplace(std::move(q.tasks.front()));
+
+        q.tasks.pop_front();
+      }
+      else
+      {
+        t.emplace(std::move(q.tasks.back()));
+
+        q.tasks.pop_back();
+      }
+
+      // NOTE: counted within the deque lock, a worker seeing pending tasks
+      // finds one unless another worker takes it first
+      pending_m.fetch_sub(1);
+
+      return t;
+    }
+
+    return std::nullopt;
+  }
+
+  static inline thread_local const worker_pool* owner_m{nullptr};
+  static inline thread_local std::optional<std::size_t> worker_idx_m;
+
+  std::mutex mtx_m; ///< protects threads, placement and stopping_m
+  std::condition_variable cond_m;
+  std::atomic<std::size_t> pending_m{0};  ///< tasks submitted, not yet popped
+  std::atomic<std::size_t> sleeping_m{0}; ///< workers waiting on cond_m
+  bool stopping_m{false};
+  std::atomic<std::size_t> next_queue_m{0};
+  std::vector<std::unique_ptr<worker_queue>> queues_m; ///< one per worker
+  std::vector<std::jthread> threads_m;
+  std::size_t num_placed_m{0}; ///< workers that allocated their queue
+};
+
+} // namespace pars::ev
@@ -31,6 +31,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "pars/init.h"
 
+#include "pars/fmt/formattable.h"
+
+#include <fmt/format.h>
+
 #include <string>
 
 #if !defined(_MSC_VER)
@@ -49,3 +53,15 @@ static const std::string demangle(const char* name)
   return name;
 }
 #endif
+
+/// name, demangled only once formatted: a log line below the level set
+/// costs no allocation
+struct demangled
+{
+  const char* name;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "{}", demangle(name));
+  }
+};
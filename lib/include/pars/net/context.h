@@ -32,11 +32,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "nngxx/aio.h"
 #include "nngxx/ctx.h"
 
+#include "pars/ev/awaitable.h"
 #include "pars/ev/enqueuer.h"
 #include "pars/net/context_opt.h"
 #include "pars/net/op.h"
 #include "pars/net/socket.h"
 
+#include <coroutine>
+
 namespace pars::net
 {
 
@@ -81,6 +84,96 @@ public:
 
   void recv() { op_m.recv(router_m, *this); }
 
+  /// @name Coroutines
+  ///
+  /// Awaited by coroutine handlers, see ev::task: they complete without
+  /// queueing sent or received events. They share the operation of the
+  /// context with send and recv above, one at a time.
+
+  template<ev::event_c event_t>
+  class send_awaitable : public ev::resumable
+  {
+  public:
+    send_awaitable(context& c, event_t ev)
+      : ctx_m{c}
+      , ev_m{std::move(ev)}
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      auto m = ev::serialize::to_network(ev_m);
+
+      suspend(h);
+
+      ctx_m.op_m.send_then(ctx_m, std::move(m),
+                           [this](clev::expected<void> res, nngxx::msg) {
+                             res_m = res;
+
+                             resume();
+                           });
+    }
+
+    clev::expected<void> await_resume() { return res_m; }
+
+  private:
+    context& ctx_m;
+    event_t ev_m;
+    clev::expected<void> res_m;
+  };
+
+  template<ev::event_c event_t>
+  class recv_awaitable : public ev::resumable
+  {
+  public:
+    explicit recv_awaitable(context& c)
+      : ctx_m{c}
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      suspend(h);
+
+      ctx_m.op_m.recv_then(ctx_m,
+                           [this](clev::expected<void> res, nngxx::msg m) {
+                             res_m = res;
+
+                             msg_m = std::move(m);
+
+                             resume();
+                           });
+    }
+
+    /// throws if the message is not an event_t
+    clev::expected<event_t> await_resume()
+    {
+      if (!res_m)
+        return clev::unexpected{res_m.error()};
+
+      return ev::serialize::to_event<event_t>(msg_m);
+    }
+
+  private:
+    context& ctx_m;
+    clev::expected<void> res_m;
+    nngxx::msg msg_m;
+  };
+
+  /// co_await send(ev): send ev, resume with the outcome
+  template<ev::event_c event_t>
+  [[nodiscard]] send_awaitable<event_t> send(event_t ev)
+  {
+    return {*this, std::move(ev)};
+  }
+
+  /// co_await recv<event_t>(): receive an event_t, resume with it
+  template<ev::event_c event_t>
+  [[nodiscard]] recv_awaitable<event_t> recv()
+  {
+    return recv_awaitable<event_t>{*this};
+  }
+
   void stop() { op_m.stop(); }
 
   int id() const { return ctx_m.id(); }
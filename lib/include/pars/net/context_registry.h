@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "nngxx/ctx.h"
 
+#include "pars/ev/slot_map.h"
 #include "pars/net/context.h"
 #include "pars/net/socket.h"
 #include "pars/net/tool_view.h"
@@ -52,8 +53,7 @@ public:
 
   void stop_all()
   {
-    for (auto& c : ctx_map_m)
-      c.second.stop();
+    ctxs_m.for_each([](auto, context& c) { c.stop(); });
   }
 
   context& emplace()
@@ -62,12 +62,14 @@ public:
 
     auto id = ctx.id();
 
-    auto res = ctx_map_m.try_emplace(id, router_m, std::move(ctx), sock_m);
-
-    if (!res.second)
+    if (ctx_keys_m.contains(id))
       throw std::runtime_error("Unable to emplace a context");
 
-    return res.first->second;
+    auto key = ctxs_m.emplace(router_m, std::move(ctx), sock_m);
+
+    ctx_keys_m.emplace(id, key);
+
+    return *ctxs_m.find(key);
   }
 
   context& of(const net::tool_view& t)
@@ -75,10 +77,12 @@ public:
     if (t.type() != typeid(nngxx::ctx_view))
       throw std::runtime_error("We need a context here");
 
-    if (ctx_map_m.find(t.id()) == ctx_map_m.end())
+    auto it = ctx_keys_m.find(t.id());
+
+    if (it == ctx_keys_m.end())
       throw std::runtime_error(fmt::format("Unknown context {}", t.id()));
 
-    return ctx_map_m.at(t.id());
+    return *ctxs_m.find(it->second);
   }
 
   void start_recv(int num_ctxs)
@@ -90,7 +94,9 @@ public:
 private:
   ev::enqueuer& router_m;
   socket& sock_m;
-  std::unordered_map<int, context> ctx_map_m;
+  ev::slot_map<context> ctxs_m; ///< contexts, they never move
+  std::unordered_map<int, ev::slot_key>
+    ctx_keys_m; ///< context id, as assigned by nng, to its key
 };
 
 } // namespace pars::net
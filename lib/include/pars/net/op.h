@@ -55,6 +55,9 @@ class op
 public:
   ~op()
   {
+    if (router_m)
+      router_m->cancel_recv(this);
+
     if (aio_m)
       aio_m.wait();
   }
@@ -103,42 +106,47 @@ public:
     t.send_aio(aio_m);
   }
 
+  /// under backpressure the receive is re-armed once the dispatcher drained
+  /// enough jobs, leaving incoming messages in nng and transport buffers
   template<tool_c tool_t>
   void recv(ev::enqueuer& r, tool_t& t)
   {
-    pars::debug(SL, lf::net, "{}: Receive Message!", f::pntl{{}, t});
+    router_m = &r;
 
-    // replace the operation with the new one
-    cb_m = [&](clev::expected<void> res, nngxx::msg m) {
-      if (res)
-      {
-        // NOTE: m is not empty on success
+    if (r.defer_recv(this, t, [this, &r, &t]() { arm_recv(r, t); }))
+    {
+      pars::debug(SL, lf::net, "{}: Receive Deferred!", f::pntl{{}, t});
 
-        auto pv = m.get_pipe();
+      return;
+    }
 
-        pars::debug(SL, lf::net, "{}: Received Message! [{}]", f::pntl{pv, t},
-                    m);
+    arm_recv(r, t);
+  }
 
-        r.queue_received(std::move(m), t.socket_id(), t, pv);
-      }
-      else
-      {
-        // NOTE: m is empty on failure
+  /// send m on t, then call f with the outcome on the nng I/O thread; sent
+  /// and network_error are not queued
+  template<tool_c tool_t>
+  void send_then(tool_t& t, nngxx::msg m, cb_f f)
+  {
+    cb_m = std::move(f);
 
-        auto pv = nngxx::pipe_view();
+    // make aio - NOTE: pass this, cant move op
+    aio_m = nngxx::make_aio(op::send_cb, this).value_or_abort();
 
-        pars::err(SL, lf::net, "{}: Error Receiving! [{}]", f::pntl{pv, t},
-                  res.error());
+    aio_m.set_msg(std::move(m));
+    t.send_aio(aio_m);
+  }
 
-        r.queue_fire(ev::network_error{res.error(), dir::in}, t.socket_id(), t,
-                     pv);
-      }
-    };
+  /// receive on t, then call f with the outcome on the nng I/O thread; the
+  /// message is not queued, nor deferred under backpressure
+  template<tool_c tool_t>
+  void recv_then(tool_t& t, cb_f f)
+  {
+    cb_m = std::move(f);
 
     // make aio - NOTE: pass this, cant move op
     aio_m = nngxx::make_aio(op::recv_cb, this).value_or_abort();
 
-    // start recv
     t.recv_aio(aio_m);
   }
 
@@ -158,6 +166,18 @@ public:
     nngxx::sleep(ms, aio_m);
   }
 
+  /// sleep for ms, then call f with the outcome on the nng I/O thread, an
+  /// error if the sleep failed or was cancelled
+  void sleep_then(nng_duration ms, cb_f f)
+  {
+    cb_m = std::move(f);
+
+    // make aio - NOTE: pass this, cant move op
+    aio_m = nngxx::make_aio(op::sleep_then_cb, this).value_or_abort();
+
+    nngxx::sleep(ms, aio_m);
+  }
+
   void reset_sleep(nng_duration ms)
   {
     stop();
@@ -231,9 +251,54 @@ public:
    *
    * Same as cancel() + wait().
    */
-  void stop() { aio_m.stop(); }
+  void stop()
+  {
+    if (router_m)
+      router_m->cancel_recv(this);
+
+    aio_m.stop();
+  }
 
 private:
+  template<tool_c tool_t>
+  void arm_recv(ev::enqueuer& r, tool_t& t)
+  {
+    pars::debug(SL, lf::net, "{}: Receive Message!", f::pntl{{}, t});
+
+    // replace the operation with the new one
+    cb_m = [&](clev::expected<void> res, nngxx::msg m) {
+      if (res)
+      {
+        // NOTE: m is not empty on success
+
+        auto pv = m.get_pipe();
+
+        pars::debug(SL, lf::net, "{}: Received Message! [{}]", f::pntl{pv, t},
+                    m);
+
+        r.queue_received(std::move(m), t.socket_id(), t, pv);
+      }
+      else
+      {
+        // NOTE: m is empty on failure
+
+        auto pv = nngxx::pipe_view();
+
+        pars::err(SL, lf::net, "{}: Error Receiving! [{}]", f::pntl{pv, t},
+                  res.error());
+
+        r.queue_fire(ev::network_error{res.error(), dir::in}, t.socket_id(), t,
+                     pv);
+      }
+    };
+
+    // make aio - NOTE: pass this, cant move op
+    aio_m = nngxx::make_aio(op::recv_cb, this).value_or_abort();
+
+    // start recv
+    t.recv_aio(aio_m);
+  }
+
   static void send_cb(void* arg)
   {
     auto self = static_cast<op*>(arg);
@@ -282,8 +347,16 @@ private:
       self->cb_m(res, nngxx::msg{});
   }
 
+  static void sleep_then_cb(void* arg)
+  {
+    auto self = static_cast<op*>(arg);
+
+    self->cb_m(self->aio_m.result(), nngxx::msg{});
+  }
+
   nngxx::aio aio_m;
   cb_f cb_m;
+  ev::enqueuer* router_m{nullptr}; ///< where a receive may be deferred
 };
 
 } // namespace pars::net
@@ -70,9 +70,10 @@ public:
   }
 
   template<template<typename> typename kind_of, ev::event_c event_t,
-           typename class_t>
+           typename class_t, ev::handler_return_c return_t>
     requires ev::kind_c<kind_of>
-  void on(void (class_t::*hf)(ev::hf_arg<kind_of, event_t>), class_t* self)
+  void on(return_t (class_t::*hf)(ev::hf_arg<kind_of, event_t>),
+          class_t* self)
   {
     insert<kind_of, event_t>(ev::make_hf(hf, self));
   }
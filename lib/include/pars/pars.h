@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "pars/app/resources.h"
 #include "pars/app/setup.h"
+#include "pars/app/sharded.h"
 #include "pars/app/single.h"
 #include "pars/app/state_machine.h"
 #include "pars/comp/backend.h"
@@ -40,9 +41,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pars/concept/hashable.h"
 #include "pars/concept/kind.h"
 #include "pars/concept/net.h"
+#include "pars/ev/awaitable.h"
 #include "pars/ev/dispatcher.h"
+#include "pars/ev/dispatcher_opt.h"
 #include "pars/ev/enqueuer.h"
+#include "pars/ev/epoch.h"
 #include "pars/ev/event.h"
+#include "pars/ev/handlers.h"
 #include "pars/ev/hf_registry.h"
 #include "pars/ev/hf_registry__insert.h"
 #include "pars/ev/job.h"
@@ -52,9 +57,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pars/ev/klass.h"
 #include "pars/ev/make_hf.h"
 #include "pars/ev/metadata.h"
+#include "pars/ev/mpsc_queue.h"
+#include "pars/ev/object_pool.h"
+#include "pars/ev/payload.h"
 #include "pars/ev/runner.h"
 #include "pars/ev/serializer.h"
+#include "pars/ev/shard.h"
+#include "pars/ev/slot_map.h"
 #include "pars/ev/spec.h"
+#include "pars/ev/task.h"
+#include "pars/ev/threading.h"
+#include "pars/ev/timer.h"
+#include "pars/ev/worker_pool.h"
 #include "pars/log/demangle.h"
 #include "pars/log/flags.h"
 #include "pars/log/nametype.h"
@@ -0,0 +1,2248 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <pars/pars.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pars::tests
+{
+
+struct ping
+{
+  int n = 0;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "ping({})", n);
+  }
+};
+
+struct alarm
+{
+  int n = 0;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "alarm({})", n);
+  }
+};
+
+struct quote
+{
+  int n = 0;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "quote({})", n);
+  }
+};
+
+struct work
+{
+  bool fail = false;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "work({})", fail);
+  }
+};
+
+struct chore
+{
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "chore()");
+  }
+};
+
+struct tick
+{
+  int n = 0;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "tick({})", n);
+  }
+};
+
+struct probe
+{
+  int n = 0;
+
+  /// the thread deserializing the last probe received
+  static inline std::atomic<std::thread::id> decoded_on{};
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "probe({})", n);
+  }
+};
+
+struct reading
+{
+  int sensor = 0;
+  int value = 0;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "reading({}, {})", sensor, value);
+  }
+};
+
+// events told apart by n only, to register many handlers
+template<int n>
+struct numbered
+{
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "numbered<{}>()", n);
+  }
+};
+
+// a timer tag
+struct reminder
+{
+  static constexpr std::string_view uuid =
+    "e4a7d2c1-5b38-4f96-8d0e-7a1c3b9f2e65";
+
+  int n = 0;
+};
+
+} // namespace pars::tests
+
+template<>
+struct pars::ev::klass<::pars::tests::tick> : base_klass<::pars::tests::tick>
+{
+  static constexpr std::string_view uuid =
+    "2e8c5a17-9f4b-4d63-a1e0-7b3d6c9f2a85";
+
+  static constexpr bool requires_network = true;
+
+  static constexpr bool droppable = true;
+
+  template<template<typename> typename kind_of>
+    requires kind_c<kind_of>
+  static constexpr executes exec_policy()
+  {
+    return is_same_kind_v<kind_of, sent> ? executes::inline_io
+                                         : executes::sync;
+  }
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::quote> : base_klass<::pars::tests::quote>
+{
+  static constexpr std::string_view uuid =
+    "7a1f3e92-0c5d-4b86-9e24-d8b6f1a3c750";
+
+  static constexpr std::chrono::milliseconds deadline{5};
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::chore> : base_klass<::pars::tests::chore>
+{
+  static constexpr std::string_view uuid =
+    "3c9e5a17-8f2b-4d60-b1e4-6a0d7c2f9b83";
+
+  static constexpr bool requires_network = false;
+
+  static constexpr std::size_t max_in_flight = 2;
+
+  template<template<typename> typename kind_of>
+    requires kind_c<kind_of>
+  static constexpr executes exec_policy()
+  {
+    return executes::async;
+  }
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::work> : base_klass<::pars::tests::work>
+{
+  static constexpr std::string_view uuid =
+    "6b0d2e8f-4c1a-4f3e-8a9b-7e5d3c2b1a09";
+
+  static constexpr bool requires_network = false;
+
+  template<template<typename> typename kind_of>
+    requires kind_c<kind_of>
+  static constexpr executes exec_policy()
+  {
+    return executes::async;
+  }
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::ping> : base_klass<::pars::tests::ping>
+{
+  static constexpr std::string_view uuid =
+    "0f6f1c55-8a7e-4a47-9d1b-6c1a3f2b9e10";
+
+  static constexpr bool requires_network = false;
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::probe> : base_klass<::pars::tests::probe>
+{
+  static constexpr std::string_view uuid =
+    "5d1e9b3a-c7f2-4a08-b6e4-1f9a2d7c3e58";
+
+  template<typename Archive>
+  static void serialize(::pars::tests::probe& ev, Archive& ar)
+  {
+    if constexpr (std::is_same_v<Archive, cereal::BinaryInputArchive>)
+      ::pars::tests::probe::decoded_on = std::this_thread::get_id();
+
+    ar(ev.n);
+  }
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::reading>
+  : base_klass<::pars::tests::reading>
+{
+  static constexpr std::string_view uuid =
+    "9d4b2f6e-1a7c-4e35-b8d0-5f3e7a9c1b26";
+
+  static constexpr bool requires_network = false;
+
+  static constexpr bool conflated = true;
+
+  static constexpr std::size_t conflation_key(const ::pars::tests::reading& r)
+  {
+    return r.sensor;
+  }
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::alarm>
+  : base_klass<::pars::tests::alarm>
+{
+  static constexpr std::string_view uuid =
+    "c3a7e0d2-5b1f-4e8a-9f3c-2d6b8a4e7f01";
+
+  static constexpr bool requires_network = false;
+
+  static constexpr ev::priority priority = ev::priority::control;
+};
+
+template<int n>
+struct pars::ev::klass<::pars::tests::numbered<n>>
+  : base_klass<::pars::tests::numbered<n>>
+{
+  static_assert(n >= 0 && n < 256);
+
+  // NOTE: hash_from_uuid tells digits from letters only, n is spelled in
+  // binary with them
+  static constexpr auto uuid_chars = []() {
+    auto u = std::to_array("00000000-0000-4000-8000-000000000000");
+
+    for (auto bit = 0; bit < 8; ++bit)
+      u[35 - bit] = (n >> bit) & 1 ? 'a' : '0';
+
+    return u;
+  }();
+
+  static constexpr std::string_view uuid{uuid_chars.data(), 36};
+
+  static constexpr bool requires_network = false;
+};
+
+namespace pars::tests
+{
+
+/// the same wiring of app::single, without any component
+struct dispatching
+{
+  ev::runner runner{hf_registry};
+  ev::hf_registry hf_registry{runner};
+  ev::dispatcher dispatcher{runner};
+
+  void start()
+  {
+    thread = std::jthread{[this]() { dispatcher.run(); }};
+
+    // jobs are discarded until the dispatcher is running
+    while (dispatcher.terminating())
+      std::this_thread::yield();
+  }
+
+  void stop()
+  {
+    dispatcher.stop_running();
+
+    dispatcher.terminate_now();
+
+    thread.join();
+  }
+
+  /// the pipe is added first, as the enqueuer does on creating_pipe
+  template<typename event_t>
+  void fire_on_pipe(event_t ev, const std::uint32_t p_id)
+  {
+    auto pv = nngxx::pipe_view{nng_pipe{p_id}};
+
+    runner.add_pipe(net::pipe{pv});
+
+    dispatcher.queue_back(
+      ev::fired{ev, {0, net::tool_view{nngxx::socket_view{}}, net::pipe{pv}}});
+  }
+
+  /// as the enqueuer does once ev is received on the pipe, still encoded
+  template<typename event_t>
+  void receive_on_pipe(event_t ev, const std::uint32_t p_id)
+  {
+    auto pv = nngxx::pipe_view{nng_pipe{p_id}};
+
+    runner.add_pipe(net::pipe{pv});
+
+    dispatcher.queue_back(
+      ev::received{ev::serialize::to_network(ev),
+                   {0, net::tool_view{nngxx::socket_view{}}, net::pipe{pv}}});
+  }
+
+  std::jthread thread;
+};
+
+struct pipe_recorder
+{
+  std::mutex mtx;
+  std::map<int, std::vector<int>> jobs_of_pipe; ///< job ids, in exec order
+  std::map<int, int> running_on_pipe;
+  bool overlapped = false;
+  std::atomic<int> executed{0};
+
+  void record(ev::hf_arg<ev::fired, ev::pipe_created> fired)
+  {
+    auto p_id = fired.md().pipe().id();
+
+    {
+      auto guard = std::lock_guard{mtx};
+
+      if (running_on_pipe[p_id]++ > 0)
+        overlapped = true;
+
+      jobs_of_pipe[p_id].push_back(fired.md().job_id());
+    }
+
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    {
+      auto guard = std::lock_guard{mtx};
+
+      --running_on_pipe[p_id];
+    }
+
+    ++executed;
+  }
+
+  void wait_for(const int n)
+  {
+    while (executed < n)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+};
+
+TEST(Dispatcher, WorkersKeepPipeJobsInOrder)
+{
+  constexpr auto num_pipes = 8;
+  constexpr auto num_jobs = 400;
+
+  auto d = dispatching{};
+  auto r = pipe_recorder{};
+
+  d.hf_registry.on<ev::fired, ev::pipe_created>(&pipe_recorder::record, &r);
+
+  d.dispatcher.set_options({.num_workers = 4});
+
+  d.start();
+
+  for (auto i = 0; i < num_jobs; ++i)
+    d.fire_on_pipe(ev::pipe_created{}, 1 + i % num_pipes);
+
+  r.wait_for(num_jobs);
+
+  d.stop();
+
+  // jobs of the same pipe never run concurrently ...
+  EXPECT_FALSE(r.overlapped);
+
+  // ... and they run in the same order they were queued
+  for (const auto& [p_id, j_ids] : r.jobs_of_pipe)
+  {
+    EXPECT_EQ(j_ids.size(), num_jobs / num_pipes);
+
+    EXPECT_TRUE(std::is_sorted(j_ids.begin(), j_ids.end()));
+  }
+}
+
+TEST(Dispatcher, OptionsCanNotChangeWhileRunning)
+{
+  auto d = dispatching{};
+
+  EXPECT_THROW(d.dispatcher.set_options({.num_workers = 0}),
+               std::invalid_argument);
+
+  d.start();
+
+  EXPECT_THROW(d.dispatcher.set_options({.num_workers = 2}),
+               std::runtime_error);
+
+  d.stop();
+}
+
+TEST(Dispatcher, DecodingOnReceiveIsOptIn)
+{
+  auto d = dispatching{};
+
+  EXPECT_EQ(d.dispatcher.options().decode_on_receive, false);
+
+  d.dispatcher.set_options({.decode_on_receive = true});
+
+  EXPECT_EQ(d.dispatcher.options().decode_on_receive, true);
+
+  // unrelated options leave it as is
+  d.dispatcher.set_options({.num_workers = 2});
+
+  EXPECT_EQ(d.dispatcher.options().decode_on_receive, true);
+}
+
+struct probe_recorder
+{
+  std::atomic<std::thread::id> handled_on{};
+  std::atomic<bool> handled{false};
+
+  void on_probe(ev::hf_arg<ev::received, probe>)
+  {
+    handled_on = std::this_thread::get_id();
+
+    handled = true;
+  }
+};
+
+TEST(Dispatcher, DecodingOnReceiveMovesItToTheProducer)
+{
+  for (auto on_receive : {false, true})
+  {
+    auto d = dispatching{};
+    auto r = probe_recorder{};
+
+    d.hf_registry.on<ev::received, probe>(&probe_recorder::on_probe, &r);
+
+    d.dispatcher.set_options({.decode_on_receive = on_receive});
+
+    d.start();
+
+    probe::decoded_on = std::thread::id{};
+
+    d.receive_on_pipe(probe{1}, 1);
+
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while (!r.handled && std::chrono::steady_clock::now() < until)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    d.stop();
+
+    ASSERT_TRUE(r.handled);
+
+    EXPECT_NE(r.handled_on.load(), std::this_thread::get_id());
+
+    // queueing on this thread decodes it here, else the worker does it
+    if (on_receive)
+      EXPECT_EQ(probe::decoded_on.load(), std::this_thread::get_id());
+    else
+      EXPECT_EQ(probe::decoded_on.load(), r.handled_on.load());
+  }
+}
+
+struct ping_recorder
+{
+  static constexpr auto num_pings = 10;
+
+  ev::dispatcher& dispatcher;
+  std::vector<int> order{};
+  std::atomic<bool> done{false};
+
+  void queue_pings(ev::hf_arg<ev::fired, ev::init>)
+  {
+    for (auto i = 0; i < num_pings; ++i)
+      dispatcher.queue_back(ev::fired{ping{i}, {}});
+  }
+
+  void record(ev::hf_arg<ev::fired, ping> fired)
+  {
+    auto n = fired.event().n;
+
+    order.push_back(n);
+
+    if (n == 0)
+      dispatcher.queue_front(ev::fired{ping{-1}, {}});
+
+    if (order.size() == num_pings + 1)
+      done = true;
+  }
+};
+
+TEST(Dispatcher, FrontJobsOvertakeTheBatch)
+{
+  auto d = dispatching{};
+  auto r = ping_recorder{d.dispatcher};
+
+  d.hf_registry.on<ev::fired, ev::init>(&ping_recorder::queue_pings, &r);
+
+  d.hf_registry.on<ev::fired, ping>(&ping_recorder::record, &r);
+
+  d.dispatcher.set_options({.batch_size = 64});
+
+  d.start();
+
+  while (!r.done)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  auto expected = std::vector<int>{0, -1, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+  EXPECT_EQ(r.order, expected);
+}
+
+struct lane_recorder
+{
+  static constexpr auto num_pings = 3;
+  static constexpr auto num_alarms = 6;
+
+  ev::dispatcher& dispatcher;
+  std::vector<std::string> order{};
+  std::atomic<bool> done{false};
+
+  void queue_events(ev::hf_arg<ev::fired, ev::init>)
+  {
+    for (auto i = 0; i < num_pings; ++i)
+      dispatcher.queue_back(ev::fired{ping{i}, {}});
+
+    for (auto i = 0; i < num_alarms; ++i)
+      dispatcher.queue_back(ev::fired{alarm{i}, {}});
+  }
+
+  void record_ping(ev::hf_arg<ev::fired, ping> fired)
+  {
+    record(fmt::format("p{}", fired.event().n));
+  }
+
+  void record_alarm(ev::hf_arg<ev::fired, alarm> fired)
+  {
+    record(fmt::format("a{}", fired.event().n));
+  }
+
+  void record(std::string s)
+  {
+    order.push_back(std::move(s));
+
+    if (order.size() == num_pings + num_alarms)
+      done = true;
+  }
+};
+
+TEST(Dispatcher, ControlLaneGoesFirstWithoutStarvingData)
+{
+  auto d = dispatching{};
+  auto r = lane_recorder{d.dispatcher};
+
+  d.hf_registry.on<ev::fired, ev::init>(&lane_recorder::queue_events, &r);
+
+  d.hf_registry.on<ev::fired, ping>(&lane_recorder::record_ping, &r);
+
+  d.hf_registry.on<ev::fired, alarm>(&lane_recorder::record_alarm, &r);
+
+  d.dispatcher.set_options({.control_burst = 2});
+
+  d.start();
+
+  while (!r.done)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  auto expected = std::vector<std::string>{"a0", "a1", "p0", "a2", "a3",
+                                           "p1", "a4", "a5", "p2"};
+
+  EXPECT_EQ(r.order, expected);
+}
+
+struct gated_pings
+{
+  std::atomic<bool> open{false};
+
+  void wait_gate(ev::hf_arg<ev::fired, ping>)
+  {
+    while (!open)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+};
+
+TEST(Dispatcher, WatermarksDeferWhileCongested)
+{
+  constexpr auto num_pings = 8;
+
+  auto d = dispatching{};
+  auto g = gated_pings{};
+
+  d.hf_registry.on<ev::fired, ping>(&gated_pings::wait_gate, &g);
+
+  d.dispatcher.set_options(
+    {.high_watermark_jobs = num_pings / 2, .low_watermark_jobs = 1});
+
+  EXPECT_THROW(d.dispatcher.set_options({.high_watermark_jobs = 1,
+                                         .low_watermark_jobs = 2}),
+               std::invalid_argument);
+
+  d.start();
+
+  auto key = 0;
+  auto resumed = std::atomic<bool>{false};
+
+  EXPECT_FALSE(d.dispatcher.defer_while_congested(&key, []() {}));
+
+  // the first ping keeps the worker busy, the others stay queued
+  for (auto i = 0; i < num_pings; ++i)
+    d.dispatcher.queue_back(ev::fired{ping{i}, {}});
+
+  EXPECT_TRUE(d.dispatcher.congested());
+
+  EXPECT_TRUE(
+    d.dispatcher.defer_while_congested(&key, [&]() { resumed = true; }));
+
+  g.open = true;
+
+  // draining below the low watermark runs what was deferred
+  while (!resumed)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  EXPECT_FALSE(d.dispatcher.congested());
+
+  d.stop();
+}
+
+TEST(Dispatcher, StoppingReleasesTheJobsItDrops)
+{
+  constexpr auto num_pings = 8;
+
+  auto d = dispatching{};
+  auto g = gated_pings{};
+
+  d.hf_registry.on<ev::fired, ping>(&gated_pings::wait_gate, &g);
+
+  d.dispatcher.set_options({.batch_size = num_pings,
+                            .high_watermark_jobs = num_pings / 2,
+                            .low_watermark_jobs = 1});
+
+  d.start();
+
+  auto key = 0;
+  auto resumed = std::atomic<bool>{false};
+
+  // the first ping keeps the worker busy, the others are in its batch or
+  // still queued
+  for (auto i = 0; i < num_pings; ++i)
+    d.dispatcher.queue_back(ev::fired{ping{i}, {}});
+
+  EXPECT_TRUE(
+    d.dispatcher.defer_while_congested(&key, [&]() { resumed = true; }));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  d.dispatcher.stop_running();
+
+  g.open = true;
+
+  d.dispatcher.terminate_now();
+
+  d.thread.join();
+
+  // neither the queued pings nor the rest of the batch are pending anymore
+  EXPECT_FALSE(d.dispatcher.congested());
+  EXPECT_TRUE(resumed);
+
+  // a restart is not congested by the pings dropped, init is pending too
+  d.start();
+
+  for (auto i = 0; i < num_pings / 2 - 2; ++i)
+    d.dispatcher.queue_back(ev::fired{ping{i}, {}});
+
+  EXPECT_FALSE(d.dispatcher.congested());
+
+  d.stop();
+}
+
+struct async_worker
+{
+  std::atomic<bool> started{false};
+  std::atomic<bool> stopped{false};
+  std::atomic<int> exceptions{0};
+
+  void do_work(ev::hf_arg<ev::fired, work> fired)
+  {
+    if (fired.event().fail)
+      throw std::runtime_error("work failed");
+
+    started = true;
+
+    auto tk = fired.md().stop_token();
+
+    while (!tk.stop_requested())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    stopped = true;
+  }
+
+  void on_exception(ev::hf_arg<ev::fired, ev::exception>) { ++exceptions; }
+
+  void on_ping(ev::hf_arg<ev::fired, ping>) {}
+};
+
+TEST(Dispatcher, AsyncCompletionsAreReaped)
+{
+  auto d = dispatching{};
+  auto w = async_worker{};
+
+  d.hf_registry.on<ev::fired, work>(&async_worker::do_work, &w);
+
+  d.hf_registry.on<ev::fired, ev::exception>(&async_worker::on_exception, &w);
+
+  d.hf_registry.on<ev::fired, ping>(&async_worker::on_ping, &w);
+
+  d.start();
+
+  d.dispatcher.queue_back(ev::fired{work{.fail = true}, {}});
+
+  // the exception is processed by whichever worker reaps the completion
+  while (w.exceptions == 0)
+  {
+    d.dispatcher.queue_back(ev::fired{ping{}, {}});
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  EXPECT_EQ(w.exceptions, 1);
+
+  d.dispatcher.queue_back(ev::fired{work{}, {}});
+
+  while (!w.started)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // stopping waits for running async jobs to complete
+  d.stop();
+
+  EXPECT_TRUE(w.stopped);
+
+  EXPECT_EQ(d.runner.count_threads(), 0u);
+
+  // frames went back to the pool, queue nodes were reused
+  auto r = d.dispatcher.recycled();
+
+  EXPECT_EQ(r.async_frames.in_use, 0u);
+  EXPECT_EQ(r.async_frames.hits + r.async_frames.misses, 2u);
+  EXPECT_GT(r.jobs.hits, 0u);
+}
+
+struct stopping_worker
+{
+  ev::dispatcher& dispatcher;
+  std::atomic<bool> started{false};
+  std::atomic<bool> queued{false};
+
+  void do_work(ev::hf_arg<ev::fired, work> fired)
+  {
+    started = true;
+
+    auto tk = fired.md().stop_token();
+
+    while (!tk.stop_requested())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // the dispatcher is stopping, waiting for this job to complete
+    dispatcher.queue_front(ev::fired{ping{}, {}});
+
+    dispatcher.queue_back(ev::fired{ping{}, {}});
+
+    queued = true;
+  }
+
+  void on_ping(ev::hf_arg<ev::fired, ping>) {}
+};
+
+TEST(Dispatcher, AsyncExceptionsAreReportedWhileIdle)
+{
+  auto d = dispatching{};
+  auto w = async_worker{};
+
+  d.hf_registry.on<ev::fired, work>(&async_worker::do_work, &w);
+
+  d.hf_registry.on<ev::fired, ev::exception>(&async_worker::on_exception, &w);
+
+  // idle workers sleep by default, nothing polls the queue
+  d.dispatcher.set_options({.num_workers = 2});
+
+  d.start();
+
+  d.dispatcher.queue_back(ev::fired{work{.fail = true}, {}});
+
+  // no further job is queued, a worker is woken to reap the completion
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+  while (w.exceptions == 0 && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  EXPECT_EQ(w.exceptions, 1);
+
+  d.stop();
+}
+
+TEST(Dispatcher, AsyncJobsMayQueueWhileStopping)
+{
+  auto d = dispatching{};
+  auto w = stopping_worker{d.dispatcher};
+
+  d.hf_registry.on<ev::fired, work>(&stopping_worker::do_work, &w);
+
+  d.hf_registry.on<ev::fired, ping>(&stopping_worker::on_ping, &w);
+
+  d.start();
+
+  d.dispatcher.queue_back(ev::fired{work{}, {}});
+
+  while (!w.started)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_TRUE(w.queued);
+
+  EXPECT_EQ(d.runner.count_threads(), 0u);
+}
+
+struct pooled_worker
+{
+  std::atomic<int> running{0};
+  std::atomic<int> peak{0};
+  std::atomic<int> cancelled{0};
+  std::mutex mtx;
+  std::set<std::thread::id> threads;
+  std::vector<int> job_ids;
+
+  void do_work(ev::hf_arg<ev::fired, work> fired)
+  {
+    auto n = ++running;
+
+    for (auto p = peak.load(); n > p && !peak.compare_exchange_weak(p, n);)
+      ;
+
+    {
+      auto guard = std::lock_guard{mtx};
+
+      threads.insert(std::this_thread::get_id());
+
+      job_ids.push_back(fired.md().job_id());
+    }
+
+    auto tk = fired.md().stop_token();
+
+    while (!tk.stop_requested())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    --running;
+
+    ++cancelled;
+  }
+};
+
+TEST(Dispatcher, AsyncJobsRunOnABoundedPool)
+{
+  auto d = dispatching{};
+  auto w = pooled_worker{};
+
+  d.hf_registry.on<ev::fired, work>(&pooled_worker::do_work, &w);
+
+  d.dispatcher.set_options({.num_async_workers = 2});
+
+  d.start();
+
+  for (auto i = 0; i < 4; ++i)
+    d.dispatcher.queue_back(ev::fired{work{}, {}});
+
+  while (w.running < 2 || d.runner.count_threads() < 4)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // the others wait for a worker of the pool
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  EXPECT_EQ(w.peak, 2);
+
+  auto first = 0;
+
+  {
+    auto guard = std::lock_guard{w.mtx};
+
+    first = w.job_ids.front();
+  }
+
+  // cancelling one job lets a waiting one take its worker
+  d.runner.stop_thread(first);
+
+  while (w.cancelled < 1 || w.running < 2)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // stopping cancels the running ones, the waiting ones start cancelled
+  d.stop();
+
+  EXPECT_EQ(w.cancelled, 4);
+  EXPECT_EQ(w.peak, 2);
+  EXPECT_EQ(w.threads.size(), 2u);
+  EXPECT_EQ(d.runner.count_threads(), 0u);
+}
+
+struct chore_runner
+{
+  std::atomic<int> running{0};
+  std::atomic<int> peak{0};
+  std::atomic<int> done{0};
+  std::atomic<bool> open{false};
+
+  void do_chore(ev::hf_arg<ev::fired, chore>)
+  {
+    auto n = ++running;
+
+    for (auto p = peak.load(); n > p && !peak.compare_exchange_weak(p, n);)
+      ;
+
+    while (!open)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    --running;
+
+    ++done;
+  }
+};
+
+TEST(Dispatcher, AsyncJobsRespectMaxInFlight)
+{
+  constexpr auto num_chores = 6;
+
+  auto d = dispatching{};
+  auto c = chore_runner{};
+
+  d.hf_registry.on<ev::fired, chore>(&chore_runner::do_chore, &c);
+
+  d.dispatcher.set_options({.num_async_workers = 4});
+
+  d.start();
+
+  for (auto i = 0; i < num_chores; ++i)
+    d.dispatcher.queue_back(ev::fired{chore{}, {}});
+
+  // two run, the others wait parked, even if async workers are idle
+  while (d.runner.count_parked() < num_chores - 2 || c.running < 2)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  EXPECT_EQ(c.running, 2);
+
+  c.open = true;
+
+  while (c.done < num_chores)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(c.peak, 2);
+  EXPECT_EQ(d.runner.count_parked(), 0u);
+  EXPECT_EQ(d.runner.count_threads(), 0u);
+}
+
+struct ticker
+{
+  std::thread::id sent_on;
+  std::atomic<int> fired{0};
+
+  void on_sent(ev::hf_arg<ev::sent, tick>)
+  {
+    sent_on = std::this_thread::get_id();
+  }
+
+  void on_fired(ev::hf_arg<ev::fired, tick>) { ++fired; }
+};
+
+TEST(Dispatcher, InlineHandlersSkipTheQueue)
+{
+  auto d = dispatching{};
+  auto t = ticker{};
+
+  d.hf_registry.on<ev::sent, tick>(&ticker::on_sent, &t);
+
+  d.hf_registry.on<ev::fired, tick>(&ticker::on_fired, &t);
+
+  // only sent and received events complete on an nng I/O thread
+  EXPECT_TRUE(d.runner.runs_inline(0, ev::spec<ev::sent<tick>>::hash));
+  EXPECT_FALSE(d.runner.runs_inline(0, ev::spec<ev::fired<tick>>::hash));
+
+  d.start();
+
+  auto e = ev::enqueuer{d.dispatcher, d.runner};
+  auto tool = net::tool_view{nngxx::ctx_view{}};
+
+  // run right away on the calling thread, as nng would do on its own
+  e.queue_sent(tick{}, 0, tool, net::pipe{});
+
+  EXPECT_EQ(t.sent_on, std::this_thread::get_id());
+
+  e.queue_fire(tick{}, 0, tool, net::pipe{});
+
+  while (t.fired == 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+}
+
+struct pipe_gate
+{
+  std::atomic<bool> entered{false};
+  std::atomic<bool> open{false};
+  std::atomic<int> executed{0};
+  std::mutex mtx;
+  std::vector<int> pipes; ///< pipe ids, in exec order
+
+  void on_tick(ev::hf_arg<ev::fired, tick> fired)
+  {
+    entered = true;
+
+    while (!open)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    {
+      auto guard = std::lock_guard{mtx};
+
+      pipes.push_back(fired.md().pipe().id());
+    }
+
+    ++executed;
+  }
+};
+
+TEST(Dispatcher, QueuedJobsOfRemovedPipesArePurged)
+{
+  constexpr auto num_jobs = 10;
+
+  auto d = dispatching{};
+  auto g = pipe_gate{};
+
+  d.hf_registry.on<ev::fired, tick>(&pipe_gate::on_tick, &g);
+
+  auto pv = nngxx::pipe_view{nng_pipe{7}};
+  auto p = net::pipe{pv};
+
+  d.runner.add_pipe(p);
+
+  d.start();
+
+  // the worker waits on the gate, jobs of pipe 7 stay queued
+  d.fire_on_pipe(tick{}, 8);
+
+  for (auto i = 0; i < num_jobs; ++i)
+    d.fire_on_pipe(tick{}, 7);
+
+  d.runner.remove_pipe(p);
+
+  // queued once removed, or on a pipe never added: a late nng callback
+  auto tool = net::tool_view{nngxx::socket_view{}};
+
+  d.dispatcher.queue_back(ev::fired{tick{}, {0, tool, p}});
+
+  auto unknown_pv = nngxx::pipe_view{nng_pipe{9}};
+
+  d.dispatcher.queue_back(ev::fired{tick{}, {0, tool, net::pipe{unknown_pv}}});
+
+  g.open = true;
+
+  while (g.executed + d.dispatcher.num_purged() < num_jobs + 3)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(g.pipes, std::vector<int>{8});
+  EXPECT_EQ(d.dispatcher.num_purged(), num_jobs + 2);
+}
+
+TEST(Dispatcher, FairQueuingTakesTurnsAcrossPipes)
+{
+  constexpr auto num_flooding = 20;
+  constexpr auto num_polite = 2;
+
+  auto d = dispatching{};
+  auto g = pipe_gate{};
+
+  d.hf_registry.on<ev::fired, tick>(&pipe_gate::on_tick, &g);
+
+  // every job costs the quantum: plain round robin
+  d.dispatcher.set_options({.batch_size = 1, .fair_quantum = 64});
+
+  d.start();
+
+  d.fire_on_pipe(tick{}, 9);
+
+  while (!g.entered)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  for (auto i = 0; i < num_flooding; ++i)
+    d.fire_on_pipe(tick{}, 1);
+
+  for (auto i = 0; i < num_polite; ++i)
+  {
+    d.fire_on_pipe(tick{}, 2);
+
+    d.fire_on_pipe(tick{}, 3);
+  }
+
+  g.open = true;
+
+  while (g.executed < 1 + num_flooding + 2 * num_polite)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  // pipes 2 and 3 did not wait for pipe 1 to be drained
+  auto first = std::vector<int>(g.pipes.begin(), g.pipes.begin() + 7);
+
+  EXPECT_EQ(first, (std::vector<int>{9, 1, 2, 3, 1, 2, 3}));
+}
+
+struct overload_recorder
+{
+  std::atomic<int> rejected{0};
+  std::atomic<int> pipe_id{0};
+
+  void on_overloaded(ev::hf_arg<ev::fired, ev::overloaded> fired)
+  {
+    pipe_id = fired.md().pipe().id();
+
+    if (fired.event().spec_hash == ev::spec<ev::fired<tick>>::hash)
+      ++rejected;
+  }
+};
+
+TEST(Dispatcher, StandingQueuesShedDroppableJobs)
+{
+  constexpr auto num_jobs = 20;
+
+  auto d = dispatching{};
+  auto g = pipe_gate{};
+  auto o = overload_recorder{};
+
+  d.hf_registry.on<ev::fired, tick>(&pipe_gate::on_tick, &g);
+
+  d.hf_registry.on<ev::fired, ev::overloaded>(
+    &overload_recorder::on_overloaded, &o);
+
+  // well above what init and the gated job wait, even with debug logging
+  d.dispatcher.set_options({.batch_size = 1,
+                            .shed_target = std::chrono::milliseconds{20},
+                            .shed_interval = std::chrono::microseconds{1}});
+
+  d.start();
+
+  d.fire_on_pipe(tick{}, 9);
+
+  while (!g.entered)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  for (auto i = 0; i < num_jobs; ++i)
+    d.fire_on_pipe(tick{}, 7);
+
+  // the queue stands while the gate is closed
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  g.open = true;
+
+  while (g.executed + o.rejected < num_jobs + 1)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  // the first job above target starts the interval, the next ones are shed
+  EXPECT_EQ(o.rejected, num_jobs - 1);
+  EXPECT_EQ(d.dispatcher.num_shed(), num_jobs - 1u);
+  EXPECT_EQ(o.pipe_id, 7);
+}
+
+struct expiry_recorder
+{
+  pipe_gate& gate;
+
+  /// quotes never run, they're all expired
+  void on_quote(ev::hf_arg<ev::fired, quote>) { ADD_FAILURE(); }
+
+  void on_expired(ev::hf_arg<ev::fired, ev::expired> fired)
+  {
+    EXPECT_EQ(fired.event().spec_hash, ev::spec<ev::fired<quote>>::hash);
+
+    auto guard = std::lock_guard{gate.mtx};
+
+    gate.pipes.push_back(-fired.md().pipe().id());
+
+    ++gate.executed;
+  }
+};
+
+TEST(Dispatcher, EarliestDeadlinesGoFirstOrExpire)
+{
+  constexpr auto num_jobs = 3;
+
+  auto d = dispatching{};
+  auto g = pipe_gate{};
+  auto e = expiry_recorder{g};
+
+  d.hf_registry.on<ev::fired, tick>(&pipe_gate::on_tick, &g);
+
+  d.hf_registry.on<ev::fired, quote>(&expiry_recorder::on_quote, &e);
+
+  d.hf_registry.on<ev::fired, ev::expired>(&expiry_recorder::on_expired, &e);
+
+  d.dispatcher.set_options({.batch_size = 1, .edf = true});
+
+  d.start();
+
+  d.fire_on_pipe(tick{}, 9);
+
+  while (!g.entered)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // jobs without a deadline go last, even if queued first
+  for (auto i = 0; i < num_jobs; ++i)
+    d.fire_on_pipe(tick{}, 1);
+
+  for (auto i = 0; i < num_jobs; ++i)
+    d.fire_on_pipe(quote{}, 2);
+
+  // quotes wait past their deadline
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  g.open = true;
+
+  while (g.executed < 1 + 2 * num_jobs)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(g.pipes, (std::vector<int>{9, -2, -2, -2, 1, 1, 1}));
+  EXPECT_EQ(d.dispatcher.num_expired(), num_jobs);
+}
+
+struct reminder_recorder
+{
+  std::mutex mtx;
+  std::vector<int> order;
+  std::atomic<int> fired{0};
+
+  void record(ev::hf_arg<ev::fired, ev::timer_expired<reminder>> fired)
+  {
+    auto guard = std::lock_guard{mtx};
+
+    order.push_back(fired.event().tag.n);
+
+    ++this->fired;
+  }
+};
+
+TEST(Dispatcher, TimersFireInOrderUnlessCancelled)
+{
+  using std::chrono::milliseconds;
+
+  auto d = dispatching{};
+  auto t = ev::timer{d.dispatcher, std::chrono::microseconds{100}};
+  auto r = reminder_recorder{};
+
+  d.hf_registry.on<ev::fired, ev::timer_expired<reminder>>(
+    &reminder_recorder::record, &r);
+
+  d.start();
+
+  // 400 ticks: armed in the second wheel, moved down before firing
+  auto late = t.arm(milliseconds{40}, reminder{2});
+  auto early = t.arm(milliseconds{2}, reminder{1});
+  auto cancelled = t.arm(milliseconds{10}, reminder{3});
+
+  EXPECT_EQ(t.size(), 3u);
+
+  EXPECT_TRUE(t.cancel(cancelled));
+  EXPECT_FALSE(t.cancel(cancelled));
+
+  while (r.fired < 2)
+    std::this_thread::sleep_for(milliseconds(1));
+
+  // fired timers can't be cancelled anymore
+  EXPECT_FALSE(t.cancel(early));
+  EXPECT_FALSE(t.cancel(late));
+  EXPECT_EQ(t.size(), 0u);
+
+  std::this_thread::sleep_for(milliseconds(20));
+
+  d.stop();
+
+  EXPECT_EQ(r.order, (std::vector<int>{1, 2}));
+}
+
+struct napper
+{
+  ev::dispatcher& dispatcher;
+  std::atomic<int> woke{0};
+  std::atomic<int> exceptions{0};
+  std::atomic<bool> resumed_on_dispatcher{true};
+
+  ev::task<> nap(ev::hf_arg<ev::fired, ping> fired)
+  {
+    auto n = fired.event().n;
+
+    auto slept = co_await ev::sleep(std::chrono::milliseconds{5});
+
+    EXPECT_TRUE(slept);
+
+    if (ev::dispatcher::current() != &dispatcher)
+      resumed_on_dispatcher = false;
+
+    ++woke;
+
+    if (n < 0)
+      throw std::runtime_error("Bad dream!");
+  }
+
+  void on_exception(ev::hf_arg<ev::fired, ev::exception>) { ++exceptions; }
+};
+
+struct strand_napper
+{
+  std::atomic<bool> in_continuation{false};
+  std::atomic<bool> overlapped{false};
+  std::atomic<int> done{0};
+
+  ev::task<> nap(ev::hf_arg<ev::fired, tick> fired)
+  {
+    if (in_continuation)
+      overlapped = true;
+
+    if (fired.event().n == 0)
+    {
+      co_await ev::sleep(std::chrono::milliseconds{5});
+
+      in_continuation = true;
+
+      // the other jobs of the pipe wait for the continuation
+      std::this_thread::sleep_for(std::chrono::milliseconds{20});
+
+      in_continuation = false;
+    }
+
+    ++done;
+  }
+};
+
+TEST(Dispatcher, CoroutineHandlersResumeOnTheStrandOfTheirPipe)
+{
+  auto d = dispatching{};
+  auto s = strand_napper{};
+
+  d.hf_registry.on<ev::fired, tick>(&strand_napper::nap, &s);
+
+  d.dispatcher.set_options({.num_workers = 2});
+
+  d.start();
+
+  d.fire_on_pipe(tick{0}, 7);
+
+  while (!s.in_continuation)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  for (auto i = 1; i < 4; ++i)
+    d.fire_on_pipe(tick{i}, 7);
+
+  while (s.done < 4)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_FALSE(s.overlapped);
+}
+
+TEST(Dispatcher, CoroutineHandlersResumeOnTheDispatcher)
+{
+  auto d = dispatching{};
+  auto n = napper{d.dispatcher};
+
+  d.hf_registry.on<ev::fired, ping>(&napper::nap, &n);
+
+  d.hf_registry.on<ev::fired, ev::exception>(&napper::on_exception, &n);
+
+  d.dispatcher.set_options({.num_workers = 2});
+
+  d.start();
+
+  d.dispatcher.queue_back(ev::fired{ping{1}, {}});
+
+  while (n.woke < 1)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // thrown once resumed, processed as thrown by the handler
+  d.dispatcher.queue_back(ev::fired{ping{-1}, {}});
+
+  while (n.exceptions < 1)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(n.woke, 2);
+  EXPECT_TRUE(n.resumed_on_dispatcher);
+
+  // the frame of the first nap is recycled by the second one
+  auto frames = d.runner.task_frame_stats();
+
+  EXPECT_GE(frames.hits, 1u);
+  EXPECT_EQ(frames.in_use, 0u);
+}
+
+struct ping_counter
+{
+  std::atomic<int> received{0};
+
+  void count(ev::hf_arg<ev::fired, ping>) { ++received; }
+};
+
+TEST(Dispatcher, SpinningWorkersPickUpJobsAfterIdleGaps)
+{
+  static constexpr auto num_pings = 20;
+
+  auto d = dispatching{};
+  auto c = ping_counter{};
+
+  d.hf_registry.on<ev::fired, ping>(&ping_counter::count, &c);
+
+  d.dispatcher.set_options(
+    {.num_workers = 2, .idle_spins = 1000, .idle_yields = 100});
+
+  EXPECT_EQ(d.dispatcher.options().idle_spins, 1000u);
+  EXPECT_EQ(d.dispatcher.options().idle_yields, 100u);
+
+  d.start();
+
+  // workers go through spinning, yielding and sleeping between pings
+  for (auto i = 0; i < num_pings; ++i)
+  {
+    d.dispatcher.queue_back(ev::fired{ping{i}, {}});
+
+    while (c.received < i + 1)
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    std::this_thread::sleep_for(std::chrono::microseconds(i * 100));
+  }
+
+  d.stop();
+
+  EXPECT_EQ(c.received, num_pings);
+}
+
+TEST(Dispatcher, ParkedWorkersNeverMissAJob)
+{
+  static constexpr auto num_producers = 8;
+  static constexpr auto num_bursts = 200;
+  static constexpr auto burst_size = 4;
+  static constexpr auto num_pings = num_producers * num_bursts * burst_size;
+
+  auto d = dispatching{};
+  auto c = ping_counter{};
+
+  d.hf_registry.on<ev::fired, ping>(&ping_counter::count, &c);
+
+  d.dispatcher.set_options({.num_workers = 4});
+
+  d.start();
+
+  // short bursts with pauses in between, workers park most of the time
+  {
+    auto producers = std::vector<std::jthread>{};
+
+    for (auto p = 0; p < num_producers; ++p)
+      producers.emplace_back([&d]() {
+        for (auto b = 0; b < num_bursts; ++b)
+        {
+          for (auto i = 0; i < burst_size; ++i)
+            d.dispatcher.queue_back(ev::fired{ping{i}, {}});
+
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+      });
+  }
+
+  // a lost wakeup leaves the last pings queued with every worker parked
+  auto until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+  while (c.received < num_pings && std::chrono::steady_clock::now() < until)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(c.received, num_pings);
+}
+
+// pings > 0 meet each other, they can only run on two workers at once
+struct rendezvous
+{
+  std::atomic<bool> warmed_up{false};
+  std::atomic<int> arrived{0};
+  std::atomic<int> met{0};
+  std::atomic<int> left{0};
+
+  void meet(ev::hf_arg<ev::fired, ping> fired)
+  {
+    if (fired.event().n == 0)
+    {
+      warmed_up = true;
+
+      return;
+    }
+
+    ++arrived;
+
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+    while (arrived < 2 && std::chrono::steady_clock::now() < until)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    if (arrived >= 2)
+      ++met;
+
+    ++left;
+  }
+};
+
+TEST(Dispatcher, SpinningWorkersDontHideABurstFromSleepingOnes)
+{
+  auto d = dispatching{};
+  auto r = rendezvous{};
+
+  d.hf_registry.on<ev::fired, ping>(&rendezvous::meet, &r);
+
+  // a worker spins long after a job, the other one sleeps meanwhile
+  d.dispatcher.set_options({.num_workers = 2, .idle_spins = 10'000'000});
+
+  d.start();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  d.dispatcher.queue_back(ev::fired{ping{0}, {}});
+
+  while (!r.warmed_up)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  // one spinning worker takes one of them, the other one needs a wake up
+  d.dispatcher.queue_back(ev::fired{ping{1}, {}});
+  d.dispatcher.queue_back(ev::fired{ping{2}, {}});
+
+  while (r.left < 2)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(r.met, 2);
+}
+
+struct registrar
+{
+  std::atomic<int> handled{0};
+
+  template<int n>
+  void count(ev::hf_arg<ev::fired, numbered<n>>)
+  {
+    ++handled;
+  }
+
+  /// register the handler of numbered<n> then fire it right away
+  template<int n>
+  void register_and_fire(dispatching& d)
+  {
+    d.hf_registry.on<ev::fired, numbered<n>>(&registrar::count<n>, this);
+
+    d.dispatcher.queue_back(ev::fired{numbered<n>{}, {}});
+  }
+};
+
+TEST(Dispatcher, HandlersRegisterWhileJobsAreLookedUp)
+{
+  static constexpr auto num_events = 64;
+
+  auto d = dispatching{};
+  auto c = ping_counter{};
+  auto r = registrar{};
+
+  d.hf_registry.on<ev::fired, ping>(&ping_counter::count, &c);
+
+  d.dispatcher.set_options({.num_workers = 4});
+
+  d.start();
+
+  auto registering = std::atomic<bool>{true};
+  auto num_pings = std::atomic<int>{0};
+
+  // pings are looked up while every registration publishes a new snapshot
+  auto pinger = std::jthread{[&](std::stop_token tk) {
+    while (registering && !tk.stop_requested())
+    {
+      d.dispatcher.queue_back(ev::fired{ping{num_pings}, {}});
+
+      ++num_pings;
+    }
+  }};
+
+  [&]<int... n>(std::integer_sequence<int, n...>) {
+    (r.register_and_fire<n>(d), ...);
+  }(std::make_integer_sequence<int, num_events>{});
+
+  registering = false;
+
+  pinger.join();
+
+  auto until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+  while ((c.received < num_pings || r.handled < num_events) &&
+         std::chrono::steady_clock::now() < until)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(c.received, num_pings);
+  EXPECT_EQ(r.handled, num_events);
+
+  // no lookup is running, the next insert frees every snapshot replaced
+  r.register_and_fire<num_events>(d);
+
+  EXPECT_EQ(d.hf_registry.num_snapshots(), 1u);
+}
+
+struct reading_recorder
+{
+  std::vector<std::pair<int, int>> readings;
+  std::atomic<bool> blocked{false};
+  std::atomic<bool> open{false};
+  std::atomic<bool> done{false};
+
+  void hold(ev::hf_arg<ev::fired, ping> fired)
+  {
+    if (fired.event().n < 0)
+    {
+      done = true;
+
+      return;
+    }
+
+    blocked = true;
+
+    while (!open)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  void record(ev::hf_arg<ev::fired, reading> fired)
+  {
+    readings.emplace_back(fired.event().sensor, fired.event().value);
+  }
+};
+
+TEST(Dispatcher, ConflatedEventsKeepTheNewestValue)
+{
+  auto d = dispatching{};
+  auto r = reading_recorder{};
+
+  d.hf_registry.on<ev::fired, ping>(&reading_recorder::hold, &r);
+
+  d.hf_registry.on<ev::fired, reading>(&reading_recorder::record, &r);
+
+  d.start();
+
+  // readings pile up while the only worker is busy
+  d.dispatcher.queue_back(ev::fired{ping{1}, {}});
+
+  while (!r.blocked)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  for (auto v = 1; v <= 5; ++v)
+  {
+    d.dispatcher.queue_back(ev::fired{reading{1, v}, {}});
+
+    if (v <= 3)
+      d.dispatcher.queue_back(ev::fired{reading{2, v}, {}});
+  }
+
+  d.dispatcher.queue_back(ev::fired{ping{-1}, {}});
+
+  r.open = true;
+
+  while (!r.done)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  // the newest value of each sensor, where its first one was queued
+  auto expected = std::vector<std::pair<int, int>>{{1, 5}, {2, 3}};
+
+  EXPECT_EQ(r.readings, expected);
+  EXPECT_EQ(d.dispatcher.num_conflated(), 6u);
+}
+
+#if defined(__linux__)
+
+struct placement_probe
+{
+  std::mutex mtx;
+  std::string name;
+  int cpu{-1};
+  std::atomic<bool> done{false};
+
+  void probe(ev::hf_arg<ev::fired, ping>)
+  {
+    {
+      auto guard = std::lock_guard{mtx};
+
+      char buf[16]{};
+
+      pthread_getname_np(pthread_self(), buf, sizeof(buf));
+
+      name = buf;
+      cpu = sched_getcpu();
+    }
+
+    done = true;
+  }
+};
+
+TEST(Dispatcher, WorkersArePlacedAsConfigured)
+{
+  auto d = dispatching{};
+  auto p = placement_probe{};
+
+  d.hf_registry.on<ev::fired, ping>(&placement_probe::probe, &p);
+
+  EXPECT_THROW(d.dispatcher.set_options(
+                 {.worker_placement = ev::thread_placement{.cpus = {-1}}}),
+               std::invalid_argument);
+
+  d.dispatcher.set_options({.worker_placement = ev::thread_placement{
+                              .name = "pars-test", .cpus = {0}}});
+
+  d.start();
+
+  d.dispatcher.queue_back(ev::fired{ping{1}, {}});
+
+  while (!p.done)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  auto guard = std::lock_guard{p.mtx};
+
+  EXPECT_EQ(p.name, "pars-test-0");
+  EXPECT_EQ(p.cpu, 0);
+}
+
+TEST(Dispatcher, CallerOfRunGetsItsPlacementBack)
+{
+  auto d = dispatching{};
+  auto p = placement_probe{};
+
+  d.hf_registry.on<ev::fired, ping>(&placement_probe::probe, &p);
+
+  d.dispatcher.set_options({.worker_placement = ev::thread_placement{
+                              .name = "pars-test", .cpus = {0}}});
+
+  auto name_before = std::string{};
+  auto name_after = std::string{};
+  auto cpus_before = cpu_set_t{};
+  auto cpus_after = cpu_set_t{};
+
+  d.thread = std::jthread{[&]() {
+    char buf[16]{};
+
+    pthread_setname_np(pthread_self(), "pars-caller");
+
+    pthread_getname_np(pthread_self(), buf, sizeof(buf));
+    pthread_getaffinity_np(pthread_self(), sizeof(cpus_before), &cpus_before);
+
+    name_before = buf;
+
+    d.dispatcher.run();
+
+    pthread_getname_np(pthread_self(), buf, sizeof(buf));
+    pthread_getaffinity_np(pthread_self(), sizeof(cpus_after), &cpus_after);
+
+    name_after = buf;
+  }};
+
+  while (d.dispatcher.terminating())
+    std::this_thread::yield();
+
+  d.dispatcher.queue_back(ev::fired{ping{1}, {}});
+
+  while (!p.done)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  {
+    auto guard = std::lock_guard{p.mtx};
+
+    EXPECT_EQ(p.name, "pars-test-0");
+  }
+
+  EXPECT_EQ(name_before, "pars-caller");
+  EXPECT_EQ(name_after, name_before);
+  EXPECT_TRUE(CPU_EQUAL(&cpus_after, &cpus_before));
+}
+
+#endif
+
+TEST(Dispatcher, QueueKeepsProducersOrder)
+{
+  constexpr auto num_producers = 8;
+  constexpr auto num_pushes = 10000;
+
+  auto q = ev::mpsc_queue<std::pair<int, int>>{};
+
+  {
+    auto producers = std::vector<std::jthread>{};
+
+    for (auto p = 0; p < num_producers; ++p)
+      producers.emplace_back([&q, p]() {
+        for (auto i = 0; i < num_pushes; ++i)
+          q.push({p, i});
+      });
+  }
+
+  EXPECT_EQ(q.size(), std::size_t{num_producers * num_pushes});
+
+  auto next = std::vector<int>(num_producers, 0);
+
+  while (auto v = q.try_pop())
+    EXPECT_EQ(v->second, next[v->first]++);
+
+  for (auto n : next)
+    EXPECT_EQ(n, num_pushes);
+
+  EXPECT_TRUE(q.empty());
+}
+
+struct static_pings
+{
+  std::atomic<int> pings{0};
+  std::atomic<int> alarms{0};
+
+  void on_ping(ev::hf_arg<ev::fired, ping>) { ++pings; }
+
+  void on_alarm(ev::hf_arg<ev::fired, alarm>) { ++alarms; }
+
+  void on_init(ev::hf_arg<ev::fired, ev::init>) {}
+};
+
+using static_ping_handlers = ev::handlers<ev::handler<&static_pings::on_ping>,
+                                          ev::handler<&static_pings::on_alarm>>;
+
+static_assert(static_ping_handlers::id<ev::fired<ping>> == 0);
+static_assert(static_ping_handlers::id<ev::fired<alarm>> == 1);
+static_assert(static_ping_handlers::id<ev::fired<ev::init>> ==
+              static_ping_handlers::size);
+
+TEST(Dispatcher, StaticHandlersRunBeforeDynamicOnes)
+{
+  auto d = dispatching{};
+  auto h = static_pings{};
+
+  d.hf_registry.on(static_ping_handlers{}, &h);
+
+  d.hf_registry.on<ev::fired, ev::init>(&static_pings::on_init, &h);
+
+  // a spec is handled once, either statically or dynamically
+  EXPECT_THROW((d.hf_registry.on<ev::fired, ping>(&static_pings::on_ping, &h)),
+               std::runtime_error);
+
+  EXPECT_THROW(d.hf_registry.on(static_ping_handlers{}, &h),
+               std::runtime_error);
+
+  d.start();
+
+  d.dispatcher.queue_back(ev::fired{ping{}, {}});
+  d.dispatcher.queue_back(ev::fired{alarm{}, {}});
+  d.dispatcher.queue_back(ev::fired{ping{}, {}});
+
+  while (h.pings + h.alarms < 3)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(h.pings, 2);
+  EXPECT_EQ(h.alarms, 1);
+}
+
+struct static_catcher
+{
+  std::atomic<int> caught{0};
+
+  void on_ping(ev::hf_arg<ev::fired, ping>)
+  {
+    throw std::runtime_error("ping failed");
+  }
+
+  void on_exception(ev::hf_arg<ev::fired, ev::exception> fired)
+  {
+    try
+    {
+      std::rethrow_exception(fired.event().eptr);
+    }
+    catch (const std::runtime_error&)
+    {
+      ++caught;
+    }
+  }
+};
+
+TEST(Dispatcher, StaticExceptionHandlersGetWhatHandlersThrow)
+{
+  auto d = dispatching{};
+  auto c = static_catcher{};
+
+  d.hf_registry.on(
+    ev::handlers<ev::handler<&static_catcher::on_ping>,
+                 ev::handler<&static_catcher::on_exception>>{},
+    &c);
+
+  d.start();
+
+  d.dispatcher.queue_back(ev::fired{ping{}, {}});
+
+  auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+  while (c.caught < 1 && std::chrono::steady_clock::now() < until)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  d.stop();
+
+  EXPECT_EQ(c.caught, 1);
+}
+
+TEST(SlotMap, KeysGetStaleOnceErased)
+{
+  auto m = ev::slot_map<std::string>{};
+
+  auto a = m.emplace("a");
+  auto b = m.emplace("b");
+
+  EXPECT_EQ(*m.find(a), "a");
+  EXPECT_EQ(*m.find(b), "b");
+
+  auto watched = m.watch(a);
+
+  EXPECT_TRUE(watched.alive());
+
+  EXPECT_TRUE(m.erase(a));
+  EXPECT_FALSE(m.erase(a));
+
+  EXPECT_FALSE(watched.alive());
+  EXPECT_FALSE(m.watch(a).alive());
+
+  // the slot of a is reused, but a is stale
+  auto c = m.emplace("c");
+
+  EXPECT_EQ(c.index, a.index);
+  EXPECT_EQ(m.find(a), nullptr);
+  EXPECT_EQ(*m.find(c), "c");
+  EXPECT_FALSE(watched.alive());
+
+  EXPECT_EQ(m.size(), 2u);
+
+  m.clear();
+
+  EXPECT_TRUE(m.empty());
+  EXPECT_FALSE(m.contains(b));
+  EXPECT_FALSE(m.contains(ev::slot_key{}));
+}
+
+TEST(Epoch, ReadersHoldBackOnlyWhatTheyMayRead)
+{
+  auto e = ev::epoch::advance();
+
+  EXPECT_TRUE(ev::epoch::quiescent_since(e));
+
+  auto pinned = std::atomic<bool>{false};
+  auto release = std::atomic<bool>{false};
+
+  auto reader = std::jthread{[&]() {
+    auto outer = ev::epoch::guard{};
+
+    {
+      // nested guards keep the outer pin
+      auto inner = ev::epoch::guard{};
+    }
+
+    pinned = true;
+
+    while (!release)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }};
+
+  while (!pinned)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // what is replaced now may be read by the reader, not what was before
+  auto later = ev::epoch::advance();
+
+  EXPECT_FALSE(ev::epoch::quiescent_since(later));
+  EXPECT_TRUE(ev::epoch::quiescent_since(e));
+
+  release = true;
+
+  reader.join();
+
+  EXPECT_TRUE(ev::epoch::quiescent_since(later));
+}
+
+TEST(WorkerPool, RunsEverySubmittedTaskOnItsWorkers)
+{
+  auto pool = ev::worker_pool{};
+
+  auto mtx = std::mutex{};
+  auto threads = std::set<std::thread::id>{};
+  auto done = std::atomic<int>{0};
+
+  auto task = [&]() {
+    {
+      auto guard = std::lock_guard{mtx};
+
+      threads.insert(std::this_thread::get_id());
+    }
+
+    ++done;
+  };
+
+  pool.start(2);
+
+  for (auto i = 0; i < 100; ++i)
+    pool.submit(task);
+
+  // a worker queues on its own deque, the other one may steal
+  pool.submit([&]() {
+    for (auto i = 0; i < 10; ++i)
+      pool.submit(task);
+  });
+
+  // stopping waits for every submitted task
+  pool.stop();
+
+  EXPECT_EQ(done, 110);
+  EXPECT_EQ(pool.pending(), 0u);
+
+  EXPECT_LE(threads.size(), 2u);
+  EXPECT_FALSE(threads.contains(std::this_thread::get_id()));
+}
+
+struct no_component
+{
+  no_component(ev::hf_registry&, ev::enqueuer&) {}
+
+  void graceful_terminate() {}
+};
+
+struct sharded_pings : app::sharded<no_component>
+{
+  static constexpr auto num_pings = 100;
+
+  std::mutex mtx;
+  std::set<std::thread::id> threads;
+  std::atomic<int> received{0};
+
+  sharded_pings()
+    : app::sharded<no_component>{4}
+  {
+  }
+
+  void startup(int, char**) override
+  {
+    hfs().on<ev::fired, ev::init>(&sharded_pings::post_pings, this);
+
+    hfs().on<ev::fired, ping>(&sharded_pings::count_ping, this);
+  }
+
+  void post_pings(ev::hf_arg<ev::fired, ev::init>)
+  {
+    for (auto i = 0; i < num_pings; ++i)
+      router().post(i % num_shards(), ping{i});
+  }
+
+  void count_ping(ev::hf_arg<ev::fired, ping>)
+  {
+    {
+      auto guard = std::lock_guard{mtx};
+
+      threads.insert(std::this_thread::get_id());
+    }
+
+    if (++received == num_pings)
+      graceful_terminate();
+  }
+};
+
+TEST(Dispatcher, ShardsRunPostedEvents)
+{
+  auto a = sharded_pings{};
+
+  EXPECT_EQ(a.exec(0, nullptr), EXIT_SUCCESS);
+
+  EXPECT_EQ(a.received, sharded_pings::num_pings);
+
+  // every shard run on its own thread
+  EXPECT_EQ(a.threads.size(), 4u);
+}
+
+struct sharded_fires : app::sharded<no_component>
+{
+  std::mutex mtx;
+  std::map<int, std::size_t> shard_of_ping; ///< by ping n
+
+  sharded_fires()
+    : app::sharded<no_component>{4}
+  {
+  }
+
+  void startup(int, char**) override
+  {
+    hfs().on<ev::fired, ev::init>(&sharded_fires::post_work, this);
+
+    hfs().on<ev::fired, work>(&sharded_fires::fire_pings, this);
+
+    hfs().on<ev::fired, ping>(&sharded_fires::record, this);
+  }
+
+  /// as exec does, without setting the logger up a second time
+  int exec_shards()
+  {
+    startup(0, nullptr);
+
+    return run();
+  }
+
+  void post_work(ev::hf_arg<ev::fired, ev::init>) { router().post(2, work{}); }
+
+  /// on an async worker of the third shard
+  void fire_pings(ev::hf_arg<ev::fired, work>)
+  {
+    router().queue_fire(ping{2});
+
+    // a thread of no shard
+    std::jthread{[this]() { router().queue_fire(ping{0}); }}.join();
+  }
+
+  void record(ev::hf_arg<ev::fired, ping> fired)
+  {
+    auto idx = std::size_t{0};
+
+    while (&shard(idx).dispatcher() != ev::dispatcher::current())
+      ++idx;
+
+    auto guard = std::lock_guard{mtx};
+
+    shard_of_ping[fired.event().n] = idx;
+
+    if (shard_of_ping.size() == 2)
+      graceful_terminate();
+  }
+};
+
+TEST(Dispatcher, ShardsKeepTheEventsTheirThreadsFire)
+{
+  auto a = sharded_fires{};
+
+  EXPECT_EQ(a.exec_shards(), EXIT_SUCCESS);
+
+  // the async worker fires on its shard, any other thread on the first one
+  EXPECT_EQ(a.shard_of_ping, (std::map<int, std::size_t>{{0, 0}, {2, 2}}));
+}
+
+TEST(Dispatcher, ShardsRunPipeEvents)
+{
+  auto s = ev::shard{};
+  auto g = pipe_gate{};
+
+  g.open = true;
+
+  s.hfs().on<ev::fired, tick>(&pipe_gate::on_tick, &g);
+
+  auto pv = nngxx::pipe_view{nng_pipe{7}};
+  auto p = net::pipe{pv};
+
+  s.runner().add_pipe(p);
+
+  // like a secondary shard, no init job is queued before the first event
+  auto thread = std::jthread{[&]() { s.dispatcher().run(false); }};
+
+  while (s.dispatcher().terminating())
+    std::this_thread::yield();
+
+  EXPECT_NO_THROW(s.dispatcher().queue_back(
+    ev::fired{tick{}, {0, net::tool_view{nngxx::socket_view{}}, p}}));
+
+  while (g.executed < 1 && !HasFailure())
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  s.dispatcher().stop_running();
+
+  s.dispatcher().terminate_now();
+
+  thread.join();
+
+  EXPECT_EQ(g.pipes, std::vector<int>{7});
+}
+
+} // namespace pars::tests
@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <type_traits>
 
 namespace pars::tests
@@ -79,4 +80,77 @@ TYPED_TEST(InternalKinds, EventsCanBeFired)
   }
 }
 
+// an event whose klass declares the required traits only
+struct bare
+{
+};
+
+// an internal event with a deadline, it has no pipe to fire expired on
+struct urgent_chore
+{
+};
+
+} // namespace pars::tests
+
+template<>
+struct pars::ev::klass<::pars::tests::urgent_chore>
+  : base_klass<::pars::tests::urgent_chore>
+{
+  static constexpr std::string_view uuid =
+    "a3e8c1f0-7d24-4b59-8e6a-1c9f0b2d5e73";
+
+  static constexpr bool requires_network = false;
+
+  static constexpr std::chrono::milliseconds deadline{5};
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::bare>
+{
+  static constexpr std::string_view uuid =
+    "6b1f0d3e-82a4-4c57-9e16-3d7a5c0b8f24";
+
+  static constexpr bool requires_network = false;
+
+  template<template<typename> typename kind_of>
+    requires kind_c<kind_of>
+  static constexpr executes exec_policy()
+  {
+    return executes::sync;
+  }
+};
+
+namespace pars::tests
+{
+
+TEST(InternalEvents, KlassTraitsDefaultWhatIsNotDeclared)
+{
+  using traits = ev::klass_traits<bare>;
+
+  EXPECT_TRUE(ev::internal_event_c<bare>);
+
+  EXPECT_EQ(traits::priority, ev::priority::data);
+  EXPECT_FALSE(traits::droppable);
+  EXPECT_EQ(traits::deadline, std::chrono::microseconds{0});
+  EXPECT_EQ(traits::max_in_flight, 0u);
+  EXPECT_FALSE(traits::conflated);
+  EXPECT_EQ(traits::conflation_key(bare{}), 0u);
+
+  // what is declared is taken as it is
+  EXPECT_EQ(ev::klass_traits<ev::resumed>::priority, ev::priority::control);
+}
+
+TEST(InternalEvents, DeadlinesMakeThemReplaceable)
+{
+  using traits = ev::klass_traits<urgent_chore>;
+
+  // hf_registry rejects it at compile time, instead of expiring it silently
+  EXPECT_EQ(traits::deadline, std::chrono::milliseconds{5});
+  EXPECT_TRUE(traits::replaceable);
+  EXPECT_TRUE(ev::internal_event_c<urgent_chore>);
+
+  EXPECT_FALSE(ev::klass_traits<bare>::replaceable);
+  EXPECT_FALSE(ev::klass_traits<ev::init>::replaceable);
+}
+
 } // namespace pars::tests
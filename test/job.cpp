@@ -0,0 +1,340 @@
+/*
+Copyright (c) 2025 Giuseppe Roberti.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <pars/pars.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+std::atomic<std::size_t> allocations{0};
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (auto* p = std::malloc(size ? size : 1))
+    return p;
+
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace pars::tests
+{
+
+struct bulky
+{
+  std::array<char, 2 * ev::payload::capacity> data{};
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "bulky({})", data.size());
+  }
+};
+
+struct sample
+{
+  int n = 0;
+
+  auto format_to(fmt::format_context& ctx) const -> decltype(ctx.out())
+  {
+    return fmt::format_to(ctx.out(), "sample({})", n);
+  }
+};
+
+} // namespace pars::tests
+
+template<>
+struct pars::ev::klass<::pars::tests::bulky> : base_klass<::pars::tests::bulky>
+{
+  static constexpr std::string_view uuid =
+    "9d4b7a21-3e6c-4f85-b0a2-5c8e1f7d3a64";
+
+  static constexpr bool requires_network = false;
+};
+
+template<>
+struct pars::ev::klass<::pars::tests::sample>
+  : base_klass<::pars::tests::sample>
+{
+  static constexpr std::string_view uuid =
+    "e2c4a6b8-1d3f-4e5a-9c7b-0f2d4e6a8c1b";
+
+  template<typename Archive>
+  static void serialize(::pars::tests::sample& ev, Archive& ar)
+  {
+    ar(ev.n);
+  }
+};
+
+namespace pars::tests
+{
+
+// the kinds of the built-in events are stored inline
+static_assert(ev::payload::fits_inline<ev::fired<ev::init>>);
+static_assert(ev::payload::fits_inline<ev::fired<ev::exception>>);
+static_assert(ev::payload::fits_inline<ev::fired<ev::shutdown>>);
+static_assert(ev::payload::fits_inline<ev::received<nngxx::msg>>);
+static_assert(ev::payload::fits_inline<ev::fired<ev::network_error>>);
+static_assert(ev::payload::fits_inline<ev::fired<ev::pipe_created>>);
+static_assert(ev::payload::fits_inline<ev::fired<ev::creating_pipe>>);
+static_assert(ev::payload::fits_inline<ev::fired<ev::pipe_removed>>);
+static_assert(!ev::payload::fits_inline<ev::fired<bulky>>);
+
+template<template<typename> typename kind_of, typename event_t>
+std::size_t allocations_to_make_and_take(kind_of<event_t> ke)
+{
+  auto s_id = ke.md().socket_id();
+  auto before = allocations.load();
+
+  ev::job j = ev::make_job(1, std::move(ke));
+  auto moved = std::move(j);
+  auto taken = moved.event<kind_of, event_t>();
+  auto allocated = allocations.load() - before;
+
+  // the event taken is the one made into the job
+  EXPECT_EQ(taken.md().socket_id(), s_id);
+
+  return allocated;
+}
+
+TEST(Job, SmallPayloadsDoNotAllocate)
+{
+  EXPECT_EQ(allocations_to_make_and_take(ev::fired<ev::init>{{}, {}}), 0);
+
+  EXPECT_EQ(allocations_to_make_and_take(ev::fired<ev::network_error>{
+              {}, {1, net::tool_view{nngxx::ctx_view{}}, net::pipe{}}}),
+            0);
+
+  EXPECT_EQ(allocations_to_make_and_take(ev::fired<ev::pipe_created>{
+              {}, {1, net::tool_view{nngxx::ctx_view{}}, net::pipe{}}}),
+            0);
+}
+
+TEST(Job, LargePayloadsGoToHeap)
+{
+  auto b = bulky{};
+  b.data.back() = 'x';
+
+  EXPECT_EQ(allocations_to_make_and_take(ev::fired<bulky>{b, {}}), 1);
+
+  auto j = ev::make_job(1, ev::fired<bulky>{b, {}});
+  auto moved = std::move(j);
+
+  EXPECT_EQ((moved.event<ev::fired, bulky>().event().data.back()), 'x');
+}
+
+TEST(Job, PayloadChecksTheStoredType)
+{
+  auto p = ev::payload{std::in_place_type<std::string>, "hello"};
+
+  EXPECT_TRUE(p.holds<std::string>());
+  EXPECT_FALSE(p.holds<int>());
+  EXPECT_THROW(p.take<int>(), std::bad_any_cast);
+
+  EXPECT_EQ(p.take<std::string>(), "hello");
+  EXPECT_FALSE(p.has_value());
+}
+
+TEST(Job, QueuedJobsReuseNodes)
+{
+  auto q = ev::mpsc_queue<ev::job>{};
+
+  q.push(ev::make_job(1, ev::fired<ev::init>{{}, {}}));
+  q.try_pop();
+
+  auto before = allocations.load();
+
+  q.push(ev::make_job(2, ev::fired<ev::init>{{}, {}}));
+  auto j = q.try_pop();
+
+  EXPECT_EQ(allocations.load() - before, 0);
+  EXPECT_EQ(j->id(), 2u);
+
+  auto stats = q.node_stats();
+
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 2u);
+  EXPECT_EQ(stats.in_use, 1u);
+}
+
+/// the same wiring of app::single, without any component
+struct received_samples
+{
+  ev::runner runner{hf_registry};
+  ev::hf_registry hf_registry{runner};
+  ev::dispatcher dispatcher{runner};
+  std::atomic<int> handled{0};
+  std::atomic<bool> open{true};
+
+  void on_sample(ev::hf_arg<ev::received, sample>)
+  {
+    while (!open)
+      std::this_thread::yield();
+
+    ++handled;
+  }
+
+  /// queue the messages on pipe, as the enqueuer does, then wait for them
+  ///
+  /// handlers wait for all of them to be queued, so a warm-up takes as many
+  /// lane nodes at once as the same number of messages received afterwards
+  void receive(std::vector<nngxx::msg>& msgs, const net::pipe& pipe)
+  {
+    auto expected = handled + static_cast<int>(msgs.size());
+
+    open = false;
+
+    for (auto& m : msgs)
+      dispatcher.queue_back(ev::received{
+        std::move(m), {0, net::tool_view{nngxx::socket_view{}}, pipe}});
+
+    open = true;
+
+    msgs.clear();
+
+    while (handled < expected)
+      std::this_thread::yield();
+  }
+};
+
+TEST(Job, ReceivedMessagesRunWithoutAllocating)
+{
+  constexpr auto num_msgs = 64;
+
+  auto r = received_samples{};
+
+  r.hf_registry.on<ev::received, sample>(&received_samples::on_sample, &r);
+
+  // debug logging formats on the heap
+  auto level = spdlog::get_level();
+
+  spdlog::set_level(spdlog::level::info);
+
+  auto thread = std::jthread{[&r]() { r.dispatcher.run(); }};
+
+  while (r.dispatcher.terminating())
+    std::this_thread::yield();
+
+  auto pv = nngxx::pipe_view{nng_pipe{1}};
+  auto pipe = net::pipe{pv};
+
+  r.runner.add_pipe(pipe);
+
+  // encoding allocates, the messages are received already encoded
+  auto encode = [&]() {
+    auto msgs = std::vector<nngxx::msg>{};
+
+    msgs.reserve(num_msgs);
+
+    for (auto i = 0; i < num_msgs; ++i)
+    {
+      auto s = sample{i};
+
+      msgs.push_back(ev::serialize::to_network(s));
+    }
+
+    return msgs;
+  };
+
+  // the first ones warm up the lane nodes and the pipe watchers
+  auto warm_up = encode();
+  auto msgs = encode();
+
+  r.receive(warm_up, pipe);
+
+  auto before = allocations.load();
+
+  r.receive(msgs, pipe);
+
+  auto allocated = allocations.load() - before;
+
+  r.dispatcher.stop_running();
+
+  r.dispatcher.terminate_now();
+
+  thread.join();
+
+  spdlog::set_level(level);
+
+  // queue_back, the lane, decoding and exec
+  EXPECT_EQ(allocated, 0u);
+  EXPECT_EQ(r.handled, 2 * num_msgs);
+}
+
+TEST(ObjectPool, SlotsAreRecycledAcrossThreads)
+{
+  constexpr auto num_threads = 8;
+  constexpr auto num_rounds = 10000;
+
+  auto p = ev::object_pool<std::pair<int, int>, 4>{};
+
+  {
+    auto threads = std::vector<std::jthread>{};
+
+    for (auto t = 0; t < num_threads; ++t)
+      threads.emplace_back([&p, t]() {
+        for (auto i = 0; i < num_rounds; ++i)
+        {
+          auto* a = p.make(t, i);
+          auto* b = p.make(i, t);
+
+          EXPECT_EQ(a->first, b->second);
+          EXPECT_EQ(a->second, b->first);
+
+          p.destroy(a);
+          p.destroy(b);
+        }
+      });
+  }
+
+  auto stats = p.stats();
+
+  EXPECT_EQ(stats.in_use, 0u);
+  EXPECT_EQ(stats.hits + stats.misses, 2u * num_threads * num_rounds);
+  EXPECT_EQ(stats.misses, stats.capacity);
+  EXPECT_LE(stats.capacity, 2u * num_threads);
+}
+
+} // namespace pars::tests